@@ -54,7 +54,7 @@ age::engine::app_result test_app::on_user_create()
     auto window_size = get_render_window().get_size();
 
     m_background_program.set_uniform("iResolution", static_cast<float>(window_size.x), static_cast<float>(window_size.y));
-    m_background_program_time_location = m_background_program.get_uniform_location("iTime");
+    m_background_program_time = m_background_program.get_uniform_handle<float>("iTime");
 
     m_background_program.set_uniform_block_binding("viewprojection_matrix", get_vp_matrix_binding());
     m_background_program.set_uniform_block_binding("model_matrix", get_model_matrix_binding());
@@ -133,7 +133,7 @@ age::engine::app_result test_app::on_update()
     m_fps_text.set_string(m_fps_stringstream.str());
 
     m_elapsed_time += m_delta_time;
-    m_background_program.set_uniform(m_background_program_time_location, m_elapsed_time);
+    m_background_program.set_uniform(m_background_program_time, m_elapsed_time);
 
     if (m_key_left)
     {
@@ -78,7 +78,7 @@ private:
     age::texture m_test_texture;
     age::texture m_test_font_texture;
 
-    int32_t m_background_program_time_location = -1;
+    age::uniform_handle<float> m_background_program_time;
 
     age::clock m_clock;
 
@@ -71,6 +71,15 @@ namespace age
 		inline vertex_buffer_object& get_default_vertex_buffer_object() { return m_default_vertex_buffer_object; }
 		inline vertex_buffer_object& get_default_element_buffer_object() { return m_default_element_buffer_object; }
 
+		inline const vertex_buffer_object& get_draw_indirect_buffer_object() const { return m_draw_indirect_buffer_object; }
+		inline const vertex_buffer_object& get_draw_transform_buffer_object() const { return m_draw_transform_buffer_object; }
+		inline vertex_buffer_object& get_draw_indirect_buffer_object() { return m_draw_indirect_buffer_object; }
+		inline vertex_buffer_object& get_draw_transform_buffer_object() { return m_draw_transform_buffer_object; }
+
+		//Ring of per draw uniform blocks, which are bound with bind_range
+		inline const vertex_buffer_object& get_uniform_stream_buffer_object() const { return m_uniform_stream_buffer_object; }
+		inline vertex_buffer_object& get_uniform_stream_buffer_object() { return m_uniform_stream_buffer_object; }
+
 		inline const uniform_buffer_object& get_vp_matrix_ubo() const{ return m_vp_matrix_ubo; }
 		inline const uniform_buffer_object& get_model_matrix_ubo() const { return m_model_matrix_ubo; }
 		inline const uniform_buffer_object& get_texture_matrix_ubo() const { return m_texture_matrix_ubo; }
@@ -83,18 +92,53 @@ namespace age
 		inline const shader& get_default_vertex_shader() const { return m_default_vertex_shader; }
 		inline const shader& get_default_fragment_shader() const { return m_default_fragment_shader; }
 		inline const shader_program& get_default_shader_program() const { return m_default_shader_program; }
+		inline const shader& get_instanced_vertex_shader() const { return m_instanced_vertex_shader; }
+		inline const shader_program& get_instanced_shader_program() const { return m_instanced_shader_program; }
+		//Variant of the default shader program which samples a texture_array at the layer of each vertex
+		inline const shader_program& get_texture_array_shader_program() const { return m_texture_array_shader_program; }
+		//Only linked if has_shader_draw_parameters() is true
+		inline const shader_program& get_indirect_shader_program() const { return m_indirect_shader_program; }
 		inline const texture& get_default_texture() const { return m_default_texture; }
 
+		//ARB_shader_draw_parameters lets the indirect shader program look up per draw data by gl_DrawIDARB
+		inline bool has_shader_draw_parameters() const { return m_shader_draw_parameters; }
+		//GL 4.4 or ARB_buffer_storage, which persistently mapped stream buffers need
+		inline bool has_buffer_storage() const { return m_buffer_storage; }
+		inline size_t get_shader_storage_offset_alignment() const { return m_shader_storage_offset_alignment; }
+		inline size_t get_uniform_buffer_offset_alignment() const { return m_uniform_buffer_offset_alignment; }
+
+		//Binds the default vertex array object and points the vertex_2d attributes at the default vertex buffer
+		void apply_default_vertex_layout();
+		//Points the vertex_2d attributes at the currently bound array buffer of the currently bound vertex array object
+		static void set_vertex_2d_attributes();
+
 		inline static engine* get_instance() { return m_instance; }
 
 		inline static constexpr uint32_t get_a_position_index() { return 0; }
 		inline static constexpr uint32_t get_a_color_index() { return 1; }
 		inline static constexpr uint32_t get_a_tex_coords_index() { return 2; }
 
+		inline static constexpr uint32_t get_i_position_index() { return 3; }
+		inline static constexpr uint32_t get_i_origin_index() { return 4; }
+		inline static constexpr uint32_t get_i_scale_index() { return 5; }
+		inline static constexpr uint32_t get_i_rotation_index() { return 6; }
+		inline static constexpr uint32_t get_i_color_index() { return 7; }
+		inline static constexpr uint32_t get_i_texture_rect_index() { return 8; }
+
 		inline static constexpr uint32_t get_vp_matrix_binding() { return 0; }
 		inline static constexpr uint32_t get_model_matrix_binding() { return 1; }
 		inline static constexpr uint32_t get_texture_matrix_binding() { return 2; }
 
+		//Shader storage block binding of the per draw transforms of the indirect shader program
+		inline static constexpr uint32_t get_draw_transform_binding() { return 0; }
+
+		inline static constexpr size_t get_vertex_stream_region_size() { return 4 * 1024 * 1024; }
+		inline static constexpr size_t get_element_stream_region_size() { return 1024 * 1024; }
+		inline static constexpr size_t get_draw_indirect_stream_region_size() { return 256 * 1024; }
+		inline static constexpr size_t get_draw_transform_stream_region_size() { return 1024 * 1024; }
+		//Far above GL_MAX_UNIFORM_BLOCK_SIZE, so the uniform ring never has to grow and bound ranges stay valid
+		inline static constexpr size_t get_uniform_stream_region_size() { return 1024 * 1024; }
+
 	protected:
 
 	private:
@@ -123,6 +167,9 @@ namespace age
 		vertex_array_object m_default_vertex_array_object;
 		vertex_buffer_object m_default_vertex_buffer_object{ vertex_buffer_object::target::array };
 		vertex_buffer_object m_default_element_buffer_object{ vertex_buffer_object::target::element_array };
+		vertex_buffer_object m_draw_indirect_buffer_object{ vertex_buffer_object::target::draw_indirect };
+		vertex_buffer_object m_draw_transform_buffer_object{ vertex_buffer_object::target::shader_storage };
+		vertex_buffer_object m_uniform_stream_buffer_object{ vertex_buffer_object::target::uniform };
 
 		uniform_buffer_object m_vp_matrix_ubo;
 		uniform_buffer_object m_model_matrix_ubo;
@@ -131,8 +178,20 @@ namespace age
 		shader m_default_vertex_shader{ shader::shader_type::vertex };
 		shader m_default_fragment_shader{ shader::shader_type::fragment };
 		shader_program m_default_shader_program;
+		shader m_instanced_vertex_shader{ shader::shader_type::vertex };
+		shader_program m_instanced_shader_program;
+		shader m_texture_array_vertex_shader{ shader::shader_type::vertex };
+		shader m_texture_array_fragment_shader{ shader::shader_type::fragment };
+		shader_program m_texture_array_shader_program;
+		shader m_indirect_vertex_shader{ shader::shader_type::vertex };
+		shader_program m_indirect_shader_program;
 		texture m_default_texture;
 
+		size_t m_shader_storage_offset_alignment = 256;
+		size_t m_uniform_buffer_offset_alignment = 256;
+		bool m_shader_draw_parameters = false;
+		bool m_buffer_storage = false;
+
 		bool m_started;
 		bool m_exit_requested;
 	};
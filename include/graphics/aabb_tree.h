@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+#include <glm/vec2.hpp>
+
+#include "rect.h"
+
+namespace age
+{
+	class view_2d;
+
+	//Dynamic bounding volume tree. Every proxy is stored with fat bounds, which are enlarged by a margin,
+	//so small movements do not touch the tree at all. Queries run in O(log n) for well balanced trees.
+	class aabb_tree
+	{
+	public:
+		using proxy_id = int32_t;
+		static constexpr proxy_id null_proxy = -1;
+
+		explicit aabb_tree(float margin = 4.0f);
+
+	public:
+		proxy_id insert(const float_rect& bounds, void* user_data);
+		void remove(proxy_id proxy);
+		//Returns true if the proxy left its fat bounds and was inserted again. The displacement of the
+		//current step enlarges the fat bounds in the direction of the movement
+		bool move(proxy_id proxy, const float_rect& bounds, const glm::vec2& displacement = glm::vec2{ 0.0f });
+		void clear();
+
+		//Builds the whole tree again top down. Worth it after many proxies were inserted at once
+		void rebuild();
+
+		void* get_user_data(proxy_id proxy) const;
+		float_rect get_fat_bounds(proxy_id proxy) const;
+
+		size_t get_size() const;
+		int32_t get_height() const;
+
+		//The callbacks return false to stop the query
+		template<typename F>
+		void query(const float_rect& area, F&& callback) const;
+		//Use render_target::map_pixel_to_coords for picking at a pixel
+		template<typename F>
+		void query(const glm::vec2& point, F&& callback) const;
+		//Proxies which are potentially visible in the view, rotated views included
+		template<typename F>
+		void query(const view_2d& view, F&& callback) const;
+		//Every pair of proxies with overlapping fat bounds exactly once
+		template<typename F>
+		void query_pairs(F&& callback) const;
+
+		//Area of the world which is visible through the view
+		static float_rect get_view_bounds(const view_2d& view);
+
+	protected:
+
+	private:
+		static constexpr int32_t null_node = -1;
+
+		struct box
+		{
+			glm::vec2 min;
+			glm::vec2 max;
+		};
+
+		struct node
+		{
+			box bounds;
+			void* user_data;
+			//Next free node while the node is in the free list
+			int32_t parent;
+			int32_t child1;
+			int32_t child2;
+			//0 for leaves, -1 for free nodes
+			int32_t height;
+
+			inline bool is_leaf() const { return child1 == null_node; }
+		};
+
+		static box to_box(const float_rect& rect);
+		static float_rect to_rect(const box& value);
+		static box combine(const box& a, const box& b);
+		static float get_perimeter(const box& value);
+		static bool contains(const box& outer, const box& inner);
+		static inline bool overlaps(const box& a, const box& b)
+		{
+			return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+		}
+
+		int32_t allocate_node();
+		void free_node(int32_t index);
+
+		void insert_leaf(int32_t leaf);
+		void remove_leaf(int32_t leaf);
+		int32_t balance(int32_t index);
+		void refit_ancestors(int32_t index);
+		int32_t build(int32_t* first, int32_t* last);
+
+		template<typename F>
+		bool traverse(const box& area, F&& callback, std::vector<int32_t>& stack) const;
+
+		std::vector<node> m_nodes;
+		int32_t m_root;
+		int32_t m_free_list;
+		size_t m_size;
+		float m_margin;
+	};
+
+	template<typename F>
+	bool aabb_tree::traverse(const box& area, F&& callback, std::vector<int32_t>& stack) const
+	{
+		if (m_root == null_node)
+			return true;
+
+		stack.clear();
+		stack.push_back(m_root);
+
+		while (!stack.empty())
+		{
+			int32_t index = stack.back();
+			stack.pop_back();
+
+			const node& current = m_nodes[index];
+
+			if (!overlaps(current.bounds, area))
+				continue;
+
+			if (current.is_leaf())
+			{
+				if (!callback(index))
+					return false;
+			}
+			else
+			{
+				stack.push_back(current.child1);
+				stack.push_back(current.child2);
+			}
+		}
+
+		return true;
+	}
+
+	template<typename F>
+	void aabb_tree::query(const float_rect& area, F&& callback) const
+	{
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+
+		traverse(to_box(area), callback, stack);
+	}
+
+	template<typename F>
+	void aabb_tree::query(const glm::vec2& point, F&& callback) const
+	{
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+
+		traverse(box{ point, point }, callback, stack);
+	}
+
+	template<typename F>
+	void aabb_tree::query(const view_2d& view, F&& callback) const
+	{
+		query(get_view_bounds(view), std::forward<F>(callback));
+	}
+
+	template<typename F>
+	void aabb_tree::query_pairs(F&& callback) const
+	{
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+
+		for (int32_t i = 0; i < static_cast<int32_t>(m_nodes.size()); ++i)
+		{
+			if (m_nodes[i].height != 0)
+				continue;
+
+			//Only pairs with a larger partner are reported, so each pair is seen once
+			bool proceed = traverse(m_nodes[i].bounds, [&](int32_t other)
+			{
+				if (other <= i)
+					return true;
+
+				return static_cast<bool>(callback(i, other));
+			}, stack);
+
+			if (!proceed)
+				return;
+		}
+	}
+}
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "vertex_2d.h"
+#include "mesh_2d.h"
 
 namespace age
 {
@@ -32,11 +33,16 @@ namespace age
 		void set_outline_color(const color& value);
 		const color& get_outline_color() const;
 
+		//Keeps the geometry in a GPU-resident mesh which is only uploaded again after it changed
+		void set_retained(bool value);
+		bool is_retained() const;
+
 	protected:
 
 	private:
 		virtual void draw(render_target& target, const render_states& states) const override;
 		virtual vertex_data on_get_vertex_data() const override;
+		virtual vertex_data on_get_outline_vertex_data() const override;
 
 		void gen_vertices();
 		void gen_outline_vertices();
@@ -58,5 +64,9 @@ namespace age
 
 		color m_fill_color;
 		color m_outline_color;
+
+		mutable retained_mesh m_mesh;
+		mutable retained_mesh m_outline_mesh;
+		bool m_retained = false;
 	};
 }
\ No newline at end of file
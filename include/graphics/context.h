@@ -6,6 +6,7 @@
 #include <thread>
 
 #include "../utility/utility.h"
+#include "gl_state.h"
 
 namespace age
 {
@@ -27,6 +28,9 @@ namespace age
 
         void flush() const;
 
+        //Mirror of the GL state of this context, it becomes gl_state::get_current() while the context is active
+        gl_state& get_gl_state();
+
     protected:
 
     private:
@@ -35,11 +39,16 @@ namespace age
 
         void create(const render_window& window, bool shared = false);
         std::shared_ptr<context> acquire_shared_context();
+        //Creates shared contexts until count of them are unused, so later acquires don't have to create one
+        void prewarm_shared_contexts(size_t count);
+        //Needs m_acquire_context_mutex to be locked
+        std::shared_ptr<context> create_shared_context();
 
         std::mutex m_acquire_context_mutex;
         std::vector<std::shared_ptr<context>> m_shared_context_list;
 
         const render_window* m_render_window{};
+        mutable gl_state m_gl_state;
 
         using gl_context_type = void;
         using gl_context_deleter = deleter<gl_context_type, delete_context_lib>;
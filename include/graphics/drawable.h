@@ -1,5 +1,9 @@
 #pragma once
 
+#include <optional>
+
+#include "rect.h"
+
 namespace age
 {
 	class render_target;
@@ -25,5 +29,9 @@ namespace age
 		friend class render_target;
 
 		virtual void draw(render_target& target, const render_states& states) const = 0;
+
+		//Bounds in the space of the render_states passed to draw, so they already contain the own transform of the drawable.
+		//render_target can only cull drawables which report them
+		virtual std::optional<float_rect> get_cull_bounds() const { return std::nullopt; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+
+namespace age
+{
+	//Mirror of the GL state of one context. All binding code goes through the state of the current context,
+	//so redundant GL calls are elided and shared contexts on other threads never see a foreign cache.
+	//Every function returns true if it had to call GL
+	class gl_state
+	{
+	public:
+		static constexpr uint32_t max_texture_units = 32;
+		static constexpr uint32_t max_indexed_buffer_bindings = 16;
+
+		gl_state();
+
+	public:
+		//State of the context which is current on the calling thread
+		static gl_state& get_current();
+		static void set_current(gl_state* value);
+
+		//Forgets everything, so the next call of every function reaches GL
+		void invalidate();
+
+		bool use_program(uint32_t program);
+		bool bind_vertex_array(uint32_t vertex_array);
+
+		bool bind_buffer(uint32_t gl_target, uint32_t buffer);
+		bool bind_buffer_base(uint32_t gl_target, uint32_t index, uint32_t buffer);
+		bool bind_buffer_range(uint32_t gl_target, uint32_t index, uint32_t buffer, size_t offset, size_t size);
+		bool is_buffer_range_bound(uint32_t gl_target, uint32_t index, uint32_t buffer, size_t offset, size_t size) const;
+
+		bool active_texture(uint32_t unit);
+		//Binds to the active texture unit
+		bool bind_texture(uint32_t gl_target, uint32_t texture);
+		bool bind_texture(uint32_t unit, uint32_t gl_target, uint32_t texture);
+
+		//GL_FRAMEBUFFER binds the draw and the read framebuffer
+		bool bind_framebuffer(uint32_t gl_target, uint32_t framebuffer);
+
+		bool set_blend_func(uint32_t src_color, uint32_t dst_color, uint32_t src_alpha, uint32_t dst_alpha);
+		bool set_blend_equation(uint32_t color, uint32_t alpha);
+
+		bool set_viewport(int32_t x, int32_t y, int32_t width, int32_t height);
+		bool set_scissor(int32_t x, int32_t y, int32_t width, int32_t height);
+		bool set_enabled(uint32_t capability, bool value);
+
+		//Deleting an object unbinds it from the current context, these keep the mirror in sync
+		void forget_program(uint32_t program);
+		void forget_vertex_array(uint32_t vertex_array);
+		void forget_buffer(uint32_t buffer);
+		void forget_texture(uint32_t texture);
+		void forget_framebuffer(uint32_t framebuffer);
+
+	protected:
+
+	private:
+		static constexpr uint32_t unknown = ~uint32_t{ 0 };
+
+		enum class buffer_slot : uint32_t
+		{
+			array = 0,
+			element_array,
+			uniform,
+			shader_storage,
+			draw_indirect,
+			pixel_pack,
+			pixel_unpack,
+			copy_read,
+			copy_write,
+
+			num_elements
+		};
+
+		enum class texture_slot : uint32_t
+		{
+			texture_2d = 0,
+			texture_2d_multisample,
+			texture_2d_array,
+
+			num_elements
+		};
+
+		struct buffer_range
+		{
+			uint32_t buffer = unknown;
+			size_t offset = 0;
+			size_t size = 0;
+		};
+
+		struct capability_state
+		{
+			uint32_t capability;
+			bool enabled;
+		};
+
+		using indexed_bindings = std::array<buffer_range, max_indexed_buffer_bindings>;
+		using texture_unit = std::array<uint32_t, static_cast<uint32_t>(texture_slot::num_elements)>;
+
+		static int32_t get_buffer_slot(uint32_t gl_target);
+		static int32_t get_texture_slot(uint32_t gl_target);
+		indexed_bindings* get_indexed_bindings(uint32_t gl_target);
+		const indexed_bindings* get_indexed_bindings(uint32_t gl_target) const;
+
+		inline static thread_local gl_state* m_current = nullptr;
+
+		uint32_t m_program;
+		uint32_t m_vertex_array;
+		std::array<uint32_t, static_cast<uint32_t>(buffer_slot::num_elements)> m_buffers;
+		indexed_bindings m_uniform_bindings;
+		indexed_bindings m_shader_storage_bindings;
+
+		uint32_t m_active_texture_unit;
+		std::array<texture_unit, max_texture_units> m_textures;
+
+		uint32_t m_draw_framebuffer;
+		uint32_t m_read_framebuffer;
+
+		std::array<uint32_t, 4> m_blend_func;
+		std::array<uint32_t, 2> m_blend_equation;
+
+		bool m_viewport_known;
+		std::array<int32_t, 4> m_viewport;
+		bool m_scissor_known;
+		std::array<int32_t, 4> m_scissor;
+
+		std::vector<capability_state> m_capabilities;
+	};
+}
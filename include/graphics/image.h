@@ -1,17 +1,25 @@
 #pragma once
 
 #include <vector>
+#include <string>
 #include <string_view>
 #include <istream>
+#include <exception>
+#include <functional>
+#include <future>
 
 #include <glm/vec2.hpp>
 #include "color.h"
+#include "rect.h"
 
 namespace age
 {
+	struct image_load_result;
+
 	class image
 	{
 	public:
+		using load_callback = std::function<void(size_t index, image_load_result& result)>;
 
 	public:
 		void create(const glm::u32vec2& size, const color& the_color = color::black);
@@ -21,11 +29,29 @@ namespace age
 		void load(const std::byte data[], size_t size);
 		void load(std::istream& is);
 
+		//Reads and decodes the files on thread_count worker threads, 0 uses one thread per hardware thread.
+		//The callback runs on the calling thread in the order of paths, so e.g. texture::load can upload an image while the next ones are decoded.
+		//At most max_in_flight images are decoded ahead of the callback, which bounds the peak memory. 0 allows two per thread
+		static void load_many(const std::vector<std::string>& paths, const load_callback& callback, size_t thread_count = 0, size_t max_in_flight = 0);
+		//Returns the results in the order of paths
+		static std::vector<image_load_result> load_many(const std::vector<std::string>& paths, size_t thread_count = 0);
+
+		//Loads the largest level of a raw_texture container
+		void load_raw(std::string_view fn);
+
 		void save(const std::string_view& fn);
+		//Encodes into memory, format is the extension without the dot, e.g. "png"
 		void save(std::vector<uint8_t>& data, const std::string_view& format);
+		//Encodes on a worker thread, e.g. to store screenshots without a hitch in the frame
+		static std::future<std::vector<uint8_t>> save_async(image img, std::string_view format);
+		//Writes a raw_texture container, which loads without decoding
+		void save_raw(std::string_view fn, bool generate_mipmaps = false) const;
 
 		void create_mask_from_color(const color& color_key, uint8_t alpha);
 
+		//Copies the source_rect of source to dest, clipped to both images. An empty source_rect copies the whole source
+		void copy(const image& source, const glm::u32vec2& dest, const uint_rect& source_rect = {});
+
 		void set_pixel(const glm::u32vec2& coords, const color& pixel_color);
 		color get_pixel(const glm::u32vec2& coords) const;
 
@@ -34,6 +60,11 @@ namespace age
 
 		void flip_horizontal();
 		void flip_vertical();
+
+		void premultiply_alpha();
+		void unpremultiply_alpha();
+		//Converts between RGBA and BGRA
+		void swap_red_blue();
 	protected:
 
 	private:
@@ -41,5 +72,14 @@ namespace age
 		std::vector<uint8_t> m_pixels;
 	};
 
+	//Image of one file of image::load_many, or the reason why it could not be loaded
+	struct image_load_result
+	{
+		image img;
+		std::exception_ptr error;
+
+		inline bool is_valid() const { return !error; }
+	};
+
 	std::istream& operator >> (std::istream& in, image& im);
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "color.h"
+
+namespace age
+{
+	//Kernels over RGBA8 pixels, count is the number of pixels. The implementation is picked once at runtime, AVX2 and SSE2 on x86, NEON on ARM and scalar code elsewhere.
+	//All implementations produce the same bytes as the scalar code
+
+	void fill_pixels(uint8_t pixels[], size_t count, const color& value);
+	//Sets the alpha of all pixels which are equal to key
+	void mask_pixels(uint8_t pixels[], size_t count, const color& key, uint8_t alpha);
+	//Reverses the order of the pixels, e.g. of one row
+	void reverse_pixels(uint8_t pixels[], size_t count);
+	//Exchanges the pixels of two ranges which must not overlap
+	void swap_pixels(uint8_t first[], uint8_t second[], size_t count);
+
+	//Multiplies the color by alpha, rounded to the nearest value
+	void premultiply_pixels(uint8_t pixels[], size_t count);
+	//Divides the color by alpha, rounded to the nearest value. Pixels with an alpha of 0 are left as they are
+	void unpremultiply_pixels(uint8_t pixels[], size_t count);
+
+	//Converts between RGBA and BGRA
+	void swap_red_blue_pixels(uint8_t pixels[], size_t count);
+
+	//Name of the instruction set the kernels run with, e.g. "avx2"
+	const char* get_image_kernels_isa();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "drawable.h"
+#include "texture.h"
+#include "color.h"
+#include "rect.h"
+#include "mesh_2d.h"
+#include "vertex_buffer_object.h"
+
+namespace age
+{
+	//Per instance data of an instanced_sprite_batch. The layout matches the instance attributes of the instanced shader program
+	struct sprite_instance
+	{
+		glm::vec2 position{};
+		glm::vec2 origin{};
+		glm::vec2 scale{ 1.0f, 1.0f };
+		//Rotation in degrees
+		float rotation{};
+		age::color color{ 255, 255, 255 };
+		//Texture rect in pixels. An empty rect covers the whole texture when passed to a batch
+		float_rect texture_rect{};
+	};
+
+	//Draws many sprites sharing one texture with a single instanced draw call.
+	//The instance data is only uploaded again after it changed.
+	class instanced_sprite_batch
+		: public drawable
+	{
+	public:
+		instanced_sprite_batch();
+		instanced_sprite_batch(const texture& texture);
+
+		instanced_sprite_batch(const instanced_sprite_batch& other) = delete;
+		instanced_sprite_batch& operator = (const instanced_sprite_batch& other) = delete;
+
+	public:
+		void set_texture(const texture& value);
+		const texture& get_texture() const;
+
+		size_t add(const sprite_instance& instance);
+		void set(size_t index, const sprite_instance& instance);
+		const sprite_instance& get(size_t index) const;
+
+		void set_instances(const sprite_instance instances[], size_t num_instances);
+		void resize(size_t num_instances);
+		void clear();
+
+		size_t get_size() const;
+
+	protected:
+
+	private:
+		virtual void draw(render_target& target, const render_states& states) const override;
+
+		void init_mesh();
+		float_rect get_full_texture_rect() const;
+		//Replaces an empty texture rect with the full texture rect
+		void apply_default_texture_rect(sprite_instance& instance) const;
+
+		const texture* m_texture;
+		std::vector<sprite_instance> m_instances;
+
+		mutable mesh_2d m_mesh;
+		mutable vertex_buffer_object m_instance_buffer_object{ vertex_buffer_object::target::array };
+		mutable bool m_needs_update = true;
+	};
+}
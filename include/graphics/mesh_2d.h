@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+
+#include "render_target.h"
+#include "vertex_2d.h"
+#include "vertex_array_object.h"
+#include "vertex_buffer_object.h"
+
+namespace age
+{
+	class mesh_2d
+	{
+	public:
+		mesh_2d();
+
+	public:
+		void upload(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices);
+		void upload(const vertex_2d vertices[], size_t num_vertices, primitive_type type);
+
+		void bind() const;
+
+		inline size_t get_num_vertices() const { return m_num_vertices; }
+		inline size_t get_num_indices() const { return m_num_indices; }
+		inline primitive_type get_primitive_type() const { return m_primitive_type; }
+		inline bool is_indexed() const { return m_num_indices != 0; }
+
+		inline vertex_array_object& get_vertex_array_object() { return m_vertex_array_object; }
+
+	protected:
+
+	private:
+		void upload_vertices(const vertex_2d vertices[], size_t num_vertices);
+
+		vertex_array_object m_vertex_array_object;
+		vertex_buffer_object m_vertex_buffer_object{ vertex_buffer_object::target::array };
+		vertex_buffer_object m_element_buffer_object{ vertex_buffer_object::target::element_array };
+
+		size_t m_num_vertices = 0;
+		size_t m_num_indices = 0;
+		primitive_type m_primitive_type = primitive_type::triangles;
+	};
+
+	//Lazily created mesh_2d for drawables which keep their geometry on the GPU.
+	//Copies don't share the GPU resources, they upload their own mesh on their next draw.
+	class retained_mesh
+	{
+	public:
+		retained_mesh() = default;
+		retained_mesh(const retained_mesh& other);
+		retained_mesh(retained_mesh&& other) noexcept = default;
+
+		retained_mesh& operator = (const retained_mesh& other);
+		retained_mesh& operator = (retained_mesh&& other) noexcept = default;
+
+	public:
+		inline void invalidate() { m_needs_update = true; }
+		void reset();
+
+		const mesh_2d& update(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices);
+		const mesh_2d& update(const vertex_2d vertices[], size_t num_vertices, primitive_type type);
+
+	protected:
+
+	private:
+		std::unique_ptr<mesh_2d> m_mesh;
+		bool m_needs_update = true;
+	};
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace age
+{
+	//Opt-in cache of linked shader programs. shader_program::link stores programs with glGetProgramBinary and loads them with glProgramBinary the next time,
+	//which skips compiling and linking. Entries are keyed by the shader sources, the attribute locations and the GL vendor, renderer and version,
+	//so a driver update just misses the cache. Entries the driver rejects are deleted and the program is compiled again.
+	//While the cache is enabled shaders compile when a program misses the cache, so compile errors are thrown by shader_program::link.
+	class program_binary_cache
+	{
+	public:
+		//Needs to be set before the engine is created to cache the default programs, e.g. to a directory below SDL_GetPrefPath.
+		//An empty directory disables the cache, which is the default
+		static void set_directory(std::string_view directory);
+		static const std::string& get_directory();
+		static bool is_enabled();
+
+		//True if the program has been linked from the cache. description identifies the program without the GL version, which is added here
+		static bool load(uint32_t program, std::string_view description);
+		//Failures are ignored, the program is compiled again the next time then
+		static void store(uint32_t program, std::string_view description);
+
+	protected:
+
+	private:
+		static std::string get_key(std::string_view description);
+		static std::string get_path(std::string_view key);
+
+		static std::string m_directory;
+	};
+}
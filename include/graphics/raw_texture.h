@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+namespace age
+{
+	//Container of pre-decoded RGBA8 pixels, which is loaded without decoding. Little endian layout:
+	//header (32 bytes): magic "AGTX", version, format, width, height, number of levels, 2 reserved words
+	//level table: offset and size of every level as 64 bit values, relative to the start of the file
+	//payload: the levels from the largest to the smallest, each one starting 16 byte aligned
+	//Mipmapped files contain the whole chain down to 1x1
+	namespace raw_texture
+	{
+		constexpr uint32_t version = 1;
+		constexpr uint32_t format_rgba8 = 1;
+		constexpr size_t header_size = 32;
+		constexpr size_t level_entry_size = 16;
+		constexpr size_t payload_alignment = 16;
+
+		//Points into the parsed data, so it is only valid as long as the data is
+		struct level
+		{
+			glm::u32vec2 size;
+			const uint8_t* pixels;
+		};
+
+		//Validates the container and returns its levels
+		std::vector<level> parse(const std::byte data[], size_t size);
+
+		//With generate_mipmaps the whole chain is built with a box filter
+		void write(std::ostream& os, const glm::u32vec2& size, const uint8_t* pixels, bool generate_mipmaps);
+
+		uint32_t get_num_levels(const glm::u32vec2& size);
+	}
+}
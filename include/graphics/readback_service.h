@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "image.h"
+#include "texture.h"
+#include "render_window.h"
+#include "../utility/utility.h"
+
+namespace age
+{
+	//Reads pixels back without stalling the frame. The GPU copies them into a pool of pixel pack buffers and every readback is guarded by a fence.
+	//The future becomes ready in poll() once the GPU has finished the copy, usually a frame or two later.
+	//Needs to be used on the thread of the engine, poll() is meant to be called once per frame
+	class readback_service
+	{
+	public:
+		readback_service(size_t num_pixel_buffers = 3);
+		~readback_service();
+
+		readback_service(const readback_service& other) = delete;
+		readback_service(readback_service&& other) = delete;
+
+		readback_service& operator = (const readback_service& other) = delete;
+		readback_service& operator = (readback_service&& other) = delete;
+
+	public:
+		//Draws into the texture have to be submitted before, e.g. by render_texture::display()
+		std::future<image> read(const texture& tex);
+		//Reads the current frame, so it needs to be called before display(). Draws batched by the window are flushed
+		std::future<image> read(render_window& window);
+
+		//Resolves the futures of the finished readbacks. With wait it blocks until all of them are finished
+		void poll(bool wait = false);
+
+		//Readbacks which have been requested but are not finished yet
+		size_t get_num_pending_readbacks() const;
+
+	protected:
+
+	private:
+		struct pending_readback
+		{
+			void* fence;
+			std::promise<image> promise;
+			size_t pixel_buffer;
+			glm::u32vec2 size;
+			//Framebuffers are stored bottom up
+			bool flip;
+		};
+
+		struct pixel_buffer
+		{
+			uint32_t id = 0;
+			size_t capacity = 0;
+		};
+
+		//Reads the color attachment 0 of the framebuffer which is bound to GL_READ_FRAMEBUFFER
+		std::future<image> read_bound_framebuffer(const glm::u32vec2& size, bool flip);
+		void retire_oldest_readback();
+
+		static uint32_t create_framebuffer();
+		static void delete_framebuffer(uint32_t handle);
+
+		std::vector<pixel_buffer> m_pixel_buffers;
+		size_t m_next_pixel_buffer = 0;
+		std::deque<pending_readback> m_pending_readbacks;
+
+		//Textures are attached to it to read them
+		unique_handle<uint32_t, delete_framebuffer> m_framebuffer;
+	};
+}
@@ -5,7 +5,9 @@
 #include <array>
 
 #include "vertex_2d.h"
+#include "mesh_2d.h"
 #include "rect.h"
+#include "texture_atlas.h"
 
 namespace age
 {
@@ -24,6 +26,8 @@ namespace age
 
 		void set_texture(const texture& value, bool reset_texture_rect = false);
 		void set_texture_rect(const uint_rect& value);
+		//Uses the page of the region as texture and its rect as texture rect
+		void set_texture_rect(const atlas_region& value);
 		
 		const uint_rect& get_texture_rect() const;
 
@@ -36,6 +40,10 @@ namespace age
 		void set_outline_color(const color& value);
 		const color& get_outline_color() const;
 
+		//Keeps the geometry in a GPU-resident mesh which is only uploaded again after it changed
+		void set_retained(bool value);
+		bool is_retained() const;
+
 		inline const std::array<vertex_2d, 4>& get_vertices() const { return m_vertices; }
 		inline const std::array<uint32_t, 6>& get_indices() const { return m_indices; }
 
@@ -47,6 +55,7 @@ namespace age
 	private:
 		virtual void draw(render_target& target, const render_states& states) const override;
 		virtual vertex_data on_get_vertex_data() const override;
+		virtual vertex_data on_get_outline_vertex_data() const override;
 
 		void update_vertices();
 		void update_outline();
@@ -64,5 +73,9 @@ namespace age
 		const texture* m_texture;
 
 		float m_outline_thickness;
+
+		mutable retained_mesh m_mesh;
+		mutable retained_mesh m_outline_mesh;
+		bool m_retained = false;
 	};
 }
\ No newline at end of file
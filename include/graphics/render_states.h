@@ -61,6 +61,19 @@ namespace age
 		inline const glm::mat4& get_transform() const { return m_transform; }
 		inline glm::mat4& get_transform() { return m_transform; }
 
+		//Drawables which only consist of triangles enable this, so that render_target can merge them with other draws
+		inline void set_batching(bool value) { m_batching = value; }
+		inline bool get_batching() const { return m_batching; }
+
+		//Deferred draws are submitted in ascending layer order
+		inline void set_layer(uint8_t value) { m_layer = value; }
+		inline uint8_t get_layer() const { return m_layer; }
+
+		//Deferred draws which are opaque may be reordered by render state within their layer, others keep their submission order.
+		//Draws with blend_none are always opaque. Only declare blended draws opaque if their order doesn't matter, e.g. fully opaque sprites which don't overlap
+		inline void set_opaque(bool value) { m_opaque = value; }
+		inline bool get_opaque() const { return m_opaque; }
+
 		inline static const render_states& get_default();
 
 	protected:
@@ -71,6 +84,9 @@ namespace age
 
 		blend_mode m_blend_mode = blend_mode::blend_alpha;
 		glm::mat4 m_transform{ 1.0f };
+		bool m_batching = false;
+		uint8_t m_layer = 0;
+		bool m_opaque = false;
 	};
 
 	const render_states& render_states::get_default()
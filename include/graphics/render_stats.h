@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace age
+{
+	//Counters of the GL work issued for one frame of a render_target
+	struct render_stats
+	{
+		uint32_t draw_calls = 0;
+		//Drawables which were skipped because they were outside of the view
+		uint32_t culled_draws = 0;
+		uint64_t vertices = 0;
+		uint64_t indices = 0;
+
+		uint64_t vertex_bytes = 0;
+		uint64_t element_bytes = 0;
+		uint64_t uniform_bytes = 0;
+		//Draw indirect and shader storage buffers
+		uint64_t other_buffer_bytes = 0;
+
+		uint32_t texture_binds = 0;
+		uint32_t program_binds = 0;
+		uint32_t blend_changes = 0;
+
+		//glGetError calls made by GL_CALL. Always 0 in release builds
+		uint64_t gl_error_checks = 0;
+
+		inline void reset() { *this = render_stats{}; }
+
+		//Stats of the active render_target, which the GL wrappers add their work to. Per thread, so upload threads never count into a frame
+		static render_stats& get_current();
+		static void set_current(render_stats* value);
+
+	private:
+		static thread_local render_stats* m_current;
+	};
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "transformable_2d.h"
+#include "drawable.h"
+
+#include "text.h"
+#include "render_stats.h"
+
+namespace age
+{
+	//Shows render_stats as text, e.g. in a corner of the window
+	class render_stats_overlay
+		: public drawable
+		, public transformable_2d
+	{
+	public:
+		render_stats_overlay(const font& the_font, uint32_t the_character_size = 16);
+
+	public:
+		//Rebuilds the text, usually once per frame with render_target::get_stats()
+		void update(const render_stats& stats);
+
+		inline text& get_text() { return m_text; }
+		inline const text& get_text() const { return m_text; }
+
+	protected:
+
+	private:
+		virtual void draw(render_target& target, const render_states& states) const override;
+
+		text m_text;
+	};
+}
@@ -1,16 +1,23 @@
 #pragma once
 
+#include <vector>
+#include <unordered_map>
+
 #include "blend_mode.h"
 #include "vertex_2d.h"
 #include "view_2d.h"
 #include "vertex_array_object.h"
+#include "render_stats.h"
 #include "vertex_buffer_object.h"
+#include "../utility/radix_sort.h"
 
 namespace age
 {
 	class drawable;
 	class render_states;
 	class texture;
+	class shader_program;
+	class mesh_2d;
 
 	enum class primitive_type : uint32_t
 	{
@@ -26,7 +33,7 @@ namespace age
 	{
 	public:
 		render_target();
-		virtual ~render_target() = default;
+		virtual ~render_target();
 
 		render_target(const render_target& other) = default;
 		render_target(render_target&& other) = default;
@@ -48,20 +55,153 @@ namespace age
 		void draw(const drawable& drawable_object, const render_states& states);
 		void draw(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices, const render_states& states);
 		void draw(const vertex_2d vertices[], size_t num_vertices, primitive_type type, const render_states& states);
+		void draw(const mesh_2d& mesh, const render_states& states);
+		//Draws num_instances instances of the mesh. The instance attributes have to be part of the vertex array object of the mesh
+		void draw_instanced(const mesh_2d& mesh, size_t num_instances, const render_states& states);
+
+		//Submits all batched geometry. Needs to be called before issuing raw OpenGL calls in between draws
+		void flush();
+
+		//Batched and deferred draws keep pointers to their program and texture until they are submitted.
+		//These submit the pending draws of the active target which use them, called before uniforms or texture contents change or a texture is destroyed
+		static void flush_pending_draws(const shader_program& program);
+		static void flush_pending_draws(const texture& tex);
+
+		void set_batching_enabled(bool value);
+		bool is_batching_enabled() const;
+
+		//Records batchable draws and submits them sorted by layer and render state on the next flush.
+		//Opaque draws within a layer may be reordered, translucent draws keep their submission order. See render_states::set_opaque
+		void set_deferred_enabled(bool value);
+		bool is_deferred_enabled() const;
+
+		//Submits batches of the default shader program with a single glMultiDrawElementsIndirect.
+		//The transforms of the draws are kept in a shader storage buffer instead of being applied to the vertices.
+		//Needs ARB_shader_draw_parameters, without it batches are transformed on the CPU as if this was disabled
+		void set_indirect_enabled(bool value);
+		bool is_indirect_enabled() const;
+
+		//Skips drawables whose bounds do not intersect the current view. Only drawables which report bounds are culled
+		void set_culling_enabled(bool value);
+		bool is_culling_enabled() const;
+
+		//Statistics of the last completed frame
+		const render_stats& get_stats() const;
 
 	protected:
 		void init();
 
+		//Makes this the target of all following GL draw calls. Pending draws of the previously active target are flushed first
+		void activate();
+		//Framebuffer object which is bound while this target is active. 0 is the default framebuffer of the window
+		virtual uint32_t get_framebuffer_id() const;
+		//Flushes the active target and forgets the framebuffer binding. Needed before framebuffers are bound directly
+		static void release_active_target();
+
+		//Ends the statistics of the current frame, called by display()
+		void finish_frame_stats();
+
 	private:
 		struct states_cache
 		{
-			blend_mode last_blend_mode = blend_mode::blend_none;
 			const texture* last_texture = nullptr;
+			glm::mat4 last_transform{ 0.0f };
+			glm::mat4 last_texture_matrix{ 0.0f };
+			//Generation of the uniform ring in which the model and texture matrix ranges were streamed
+			uint64_t last_uniform_generation = ~uint64_t{ 0 };
+			size_t last_transform_offset = 0;
+			size_t last_texture_matrix_offset = 0;
+			uint32_t last_vertex_buffer_id = 0;
+		};
+
+		//Layout of DrawElementsIndirectCommand
+		struct draw_elements_indirect_command
+		{
+			uint32_t count;
+			uint32_t instance_count;
+			uint32_t first_index;
+			int32_t base_vertex;
+			uint32_t base_instance;
+		};
+
+		struct batch
+		{
+			std::vector<vertex_2d> vertices;
+			std::vector<uint32_t> indices;
+
+			const shader_program* current_program = nullptr;
+			const texture* current_texture = nullptr;
+			blend_mode current_blend_mode = blend_mode::blend_none;
+
+			//Only used by indirect batches, which keep one command and one transform per draw
+			bool indirect = false;
+			std::vector<draw_elements_indirect_command> commands;
+			std::vector<glm::mat4> transforms;
+			size_t draw_first_vertex = 0;
+			size_t draw_first_index = 0;
+		};
+
+		struct queued_command
+		{
+			const shader_program* program;
+			const texture* tex;
+			blend_mode mode;
+
+			size_t first_vertex;
+			size_t num_vertices;
+			size_t first_index;
+			size_t num_indices;
 		};
 
-		void prepare_draw(const vertex_2d vertices[], size_t num_vertices, const render_states& states);
-		void prepare_draw(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices, const render_states& states);
+		struct render_queue
+		{
+			std::vector<queued_command> commands;
+			std::vector<vertex_2d> vertices;
+			//Indices are relative to the first vertex of their command
+			std::vector<uint32_t> indices;
+
+			std::vector<radix_sort_item> keys;
+			std::vector<radix_sort_item> scratch;
+
+			//Per frame ids of the render states which are packed into the sort keys
+			std::vector<const shader_program*> programs;
+			std::unordered_map<const texture*, uint32_t> textures;
+			std::vector<blend_mode> blend_modes;
+		};
+
+		static constexpr size_t max_batch_vertices = 1 << 16;
+
+		static constexpr size_t max_queued_programs = 1 << 8;
+		static constexpr size_t max_queued_textures = 1 << 16;
+		static constexpr size_t max_queued_blend_modes = 1 << 6;
+		static constexpr size_t max_queued_commands = 1 << 24;
+
+		//Tests the bounds against the view in clip space, where the view is the same square no matter how it is rotated
+		bool is_visible(const float_rect& bounds, const glm::mat4& transform) const;
+
+		bool can_batch(primitive_type type, const render_states& states) const;
+		bool is_batch_compatible(size_t num_vertices, const shader_program& program, const texture& tex, const blend_mode& mode) const;
+		void append_to_batch(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices, const render_states& states);
+		void append_to_batch(const vertex_2d vertices[], size_t num_vertices, primitive_type type, const render_states& states);
+		uint32_t begin_batch_draw(const vertex_2d vertices[], size_t num_vertices, const shader_program& program, const texture& tex, const blend_mode& mode, const glm::mat4& transform);
+		void end_batch_draw();
+		bool uses_indirect(const shader_program& program) const;
+		void flush_batch();
+		void submit_indirect_batch(size_t base_vertex, size_t index_offset);
+
+		bool can_defer(primitive_type type, const render_states& states) const;
+		void append_to_queue(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices, const render_states& states);
+		void append_to_queue(const vertex_2d vertices[], size_t num_vertices, primitive_type type, const render_states& states);
+		queued_command& push_queued_command(const vertex_2d vertices[], size_t num_vertices, const render_states& states);
+		uint64_t make_sort_key(const render_states& states);
+		void submit_queue();
+
+		size_t stream_vertices(const vertex_2d vertices[], size_t num_vertices);
+		size_t stream_indices(const uint32_t indices[], size_t num_indices);
+		void apply_states(const shader_program& program, const texture& tex, const blend_mode& mode, const glm::mat4& transform);
 		void apply_blend_mode(const blend_mode& mode);
+		void apply_viewport();
+		void record_draw(size_t num_draw_calls, size_t num_vertices, size_t num_indices);
 
 		const glm::mat4& get_inverse_projection() const;
 
@@ -69,8 +209,23 @@ namespace age
 		int_rect m_viewport;
 		glm::mat4 m_projection_matrix{ 1.0f };
 		mutable glm::mat4 m_projection_matrix_inverse{ 1.0f };
-		states_cache m_states_cache;
+		//The cached states are global GL state, so they are shared by all targets
+		//GL state itself is mirrored by gl_state, this only remembers the values behind the bound uniform ranges
+		static thread_local states_cache m_states_cache;
+		//Every thread has its own context, so the active target is per thread like gl_state. Upload threads never see the draws of the main thread
+		inline static thread_local render_target* m_active_target = nullptr;
+
+		batch m_batch;
+		render_queue m_queue;
+
+		render_stats m_stats;
+		render_stats m_last_frame_stats;
+		uint64_t m_gl_error_check_count_at_frame_start = 0;
 
 		mutable bool m_projection_needs_update;
+		bool m_batching_enabled;
+		bool m_deferred_enabled;
+		bool m_indirect_enabled;
+		bool m_culling_enabled;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "render_target.h"
+
+#include <glm/vec2.hpp>
+
+#include "texture.h"
+#include "color.h"
+#include "../utility/utility.h"
+
+namespace age
+{
+	//Offscreen render target which draws into a texture through a framebuffer object.
+	//The result can be drawn like any other texture after display() has been called.
+	class render_texture
+		: public render_target
+	{
+	public:
+		render_texture();
+
+		render_texture(const render_texture& other) = delete;
+		render_texture(render_texture&& other) = delete;
+
+		render_texture& operator = (const render_texture& other) = delete;
+		render_texture& operator = (render_texture&& other) = delete;
+
+	public:
+		//samples > 0 renders into multisampled renderbuffers which are resolved into the texture on display()
+		void create(const glm::u32vec2& size, uint32_t samples = 0, bool depth_stencil = false);
+
+		void clear(const color& clear_color = color{ 0, 0, 0, 0 });
+		void display();
+
+		const texture& get_texture() const;
+
+		void set_smooth(bool value);
+		bool get_smooth() const;
+
+		void set_repeat(bool value);
+		bool get_repeat() const;
+
+		uint32_t get_samples() const;
+		bool has_depth_stencil() const;
+
+		glm::u32vec2 get_size() const override;
+
+	protected:
+		uint32_t get_framebuffer_id() const override;
+
+	private:
+		static uint32_t create_framebuffer();
+		static void delete_framebuffer(uint32_t handle);
+		static uint32_t create_renderbuffer();
+		static void delete_renderbuffer(uint32_t handle);
+
+		static void check_framebuffer_status();
+
+		texture m_texture;
+
+		//Receives the draws. With multisampling it is the multisampled framebuffer, otherwise the texture is attached directly
+		unique_handle<uint32_t, delete_framebuffer> m_framebuffer;
+		//Only used with multisampling, the texture is attached to it to resolve the multisampled framebuffer
+		unique_handle<uint32_t, delete_framebuffer> m_resolve_framebuffer;
+
+		unique_handle<uint32_t, delete_renderbuffer> m_color_renderbuffer;
+		unique_handle<uint32_t, delete_renderbuffer> m_depth_stencil_renderbuffer;
+
+		uint32_t m_samples = 0;
+		bool m_depth_stencil = false;
+	};
+}
@@ -6,9 +6,11 @@
 #include <functional>
 #include <type_traits>
 #include <string_view>
+#include <optional>
 
 #include <glm/vec2.hpp>
 #include <graphics/context.h>
+#include "image.h"
 #include "../utility/utility.h"
 
 namespace age
@@ -19,6 +21,10 @@ namespace age
 	public:
 		friend class engine;
 		friend class transient_context_lock;
+		friend class texture;
+		friend class readback_service;
+
+		using capture_callback = std::function<void(render_window&)>;
 
 		virtual ~render_window() = default;
 
@@ -35,7 +41,24 @@ namespace age
 		void display();
 
 		glm::u32vec2 get_size() const override;
+
+		//Headless windows render into an offscreen framebuffer and display() never presents anything
+		bool is_headless() const;
+		//Called by display() of a headless window, e.g. to compare frames against golden images
+		void set_capture_callback(capture_callback callback);
+		//Reads back the current frame
+		image capture();
+
+		//Creates the shared GL contexts of worker threads ahead of time, e.g. at startup,
+		//so the first transient_context_lock of a thread doesn't have to wait for the context creation
+		void prewarm_shared_contexts(size_t count);
+
+		//Set APOLLO_HEADLESS to "1" or to a size like "1280x720" to run without a display
+		static std::optional<glm::u32vec2> get_headless_request();
+
 	protected:
+		uint32_t get_framebuffer_id() const override;
+
 
 	private:
 		render_window();
@@ -46,11 +69,26 @@ namespace age
 
 		static void destroy_window_lib(void* window);
 
+		static uint32_t create_framebuffer();
+		static void delete_framebuffer(uint32_t handle);
+		static uint32_t create_renderbuffer();
+		static void delete_renderbuffer(uint32_t handle);
+
+		void create_headless_framebuffer(const glm::u32vec2& size);
+
 		context m_context;
 
 		using window_handle_deleter = deleter<void, destroy_window_lib>;
 		std::unique_ptr<void, window_handle_deleter> m_windowhandle;
 
 		uint32_t m_clear_flags = 0;
+
+		bool m_headless = false;
+		glm::u32vec2 m_headless_size{ 0, 0 };
+		capture_callback m_capture_callback;
+
+		unique_handle<uint32_t, delete_framebuffer> m_headless_framebuffer;
+		unique_handle<uint32_t, delete_renderbuffer> m_headless_color_renderbuffer;
+		unique_handle<uint32_t, delete_renderbuffer> m_headless_depth_stencil_renderbuffer;
 	};
 }
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+#include "drawable.h"
+#include "transformable_2d.h"
+
+namespace age
+{
+	//Hierarchy of nodes with local transforms. The nodes are stored contiguously with parents in front of their children,
+	//so the world transforms are updated in one linear pass which only touches the subtrees below changed nodes.
+	//Drawables attached to nodes are drawn with the world transform of their node, their own transform should be left untouched
+	class scene_graph
+		: public drawable
+	{
+	public:
+		using node_id = uint32_t;
+		static constexpr node_id null_node = ~node_id{ 0 };
+
+		scene_graph() = default;
+
+	public:
+		node_id create_node(node_id parent = null_node, const drawable* drawable_object = nullptr);
+		//Destroys the node and its whole subtree
+		void destroy_node(node_id id);
+		void clear();
+
+		void set_parent(node_id id, node_id parent);
+		node_id get_parent(node_id id) const;
+
+		void set_drawable(node_id id, const drawable* value);
+		const drawable* get_drawable(node_id id) const;
+
+		const transformable_2d& get_local(node_id id) const;
+		//Marks the node as changed, so its subtree gets new world transforms
+		transformable_2d& edit_local(node_id id);
+
+		const glm::mat4& get_world_transform(node_id id) const;
+
+		//Draws the node and all of its descendants
+		void draw_subtree(render_target& target, node_id id, const render_states& states) const;
+
+		size_t get_size() const;
+
+	protected:
+
+	private:
+		void draw(render_target& target, const render_states& states) const override;
+
+		uint32_t get_slot(node_id id) const;
+		//Puts the nodes into breadth first order and drops the removed ones
+		void sort_nodes(const std::vector<uint8_t>& removed);
+		void ensure_world_transforms_are_updated() const;
+
+		//Per slot, in breadth first order
+		std::vector<node_id> m_ids;
+		std::vector<uint32_t> m_parents;
+		std::vector<transformable_2d> m_locals;
+		std::vector<const drawable*> m_drawables;
+		mutable std::vector<glm::mat4> m_worlds;
+		mutable std::vector<uint8_t> m_dirty;
+		mutable std::vector<uint8_t> m_changed;
+
+		//Per node id
+		std::vector<uint32_t> m_slots;
+		std::vector<node_id> m_free_ids;
+
+		mutable bool m_world_transforms_need_update = false;
+	};
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <string_view>
 #include <cstdint>
 
@@ -23,6 +24,7 @@ namespace age
 		
 	public:
 		shader_type get_type() const { return m_type; }
+		//With the program_binary_cache enabled, compiling waits until a program using the shader misses the cache
 		void compile(std::string_view shader_source);
 
 	protected:
@@ -33,9 +35,15 @@ namespace age
 		static void delete_handle(uint32_t handle);
 
 		uint32_t get_handle() const { return m_handle; }
+		const std::string& get_source() const { return m_source; }
+		//Does nothing if the source is compiled already
+		void compile_source() const;
 
 		unique_handle<uint32_t, delete_handle> m_handle;
 
 		shader_type m_type;
+		//Part of the key of the program_binary_cache
+		std::string m_source;
+		mutable bool m_compiled = false;
 	};
 }
\ No newline at end of file
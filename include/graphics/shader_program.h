@@ -1,17 +1,62 @@
 #pragma once
 
 #include <vector>
+#include <string>
 #include <string_view>
 
 #include "shader.h"
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x3.hpp>
 #include <glm/mat4x4.hpp>
 #include "../utility/utility.h"
+#include "../utility/name_table.h"
 
 namespace age
 {
+	//Uniform of one shader_program, resolved once by name. Values set through it are kept by the program and uploaded when it is bound the next time, only if they changed.
+	//T is float, int32_t (also for samplers), uint32_t, a glm vector of these or glm::mat3/glm::mat4. Handles become invalid when the program is linked again
+	template <typename T>
+	class uniform_handle
+	{
+	public:
+		uniform_handle() = default;
+
+		//False if the uniform is not active in the program, setting it does nothing then
+		bool is_valid() const { return m_index != invalid_index; }
+
+	protected:
+
+	private:
+		friend class shader_program;
+
+		static constexpr uint32_t invalid_index = ~uint32_t{ 0 };
+
+		explicit uniform_handle(uint32_t index) : m_index{ index } {}
+
+		uint32_t m_index = invalid_index;
+	};
+
 	class shader_program
 	{
 	public:
+		//Active uniform found after link(). Uniforms within blocks have no location and are not part of it
+		struct uniform_info
+		{
+			int32_t location = -1;
+			//GL type, e.g. GL_FLOAT_VEC2
+			uint32_t type = 0;
+			//Number of elements of arrays, 1 otherwise
+			int32_t array_size = 0;
+		};
+
+		struct uniform_block_info
+		{
+			uint32_t index = 0;
+			uint32_t data_size = 0;
+		};
+
 		shader_program();
 
 	public:
@@ -20,16 +65,40 @@ namespace age
 
 		void bind_attrib_location(uint32_t index, std::string_view name);
 
+		//Loads the program from the program_binary_cache if it is enabled. The attached shaders have to stay alive until then
 		void link();
 		void bind() const;
 		void release();
 
+		//Looked up in the uniforms reflected by link(), which doesn't go to the driver
 		int32_t get_uniform_location(std::string_view name) const;
 		uint32_t get_uniform_block_index(std::string_view name) const;
+		//nullptr if there is no such active uniform or block
+		const uniform_info* find_uniform(std::string_view name) const;
+		const uniform_block_info* find_uniform_block(std::string_view name) const;
+
+		//Throws if T doesn't match the type of the uniform, returns an invalid handle if the uniform is not active
+		template <typename T>
+		uniform_handle<T> get_uniform_handle(std::string_view name) const;
+
+		template <typename T>
+		void set_uniform(uniform_handle<T> handle, const T& value) const
+		{
+			if (handle.is_valid())
+				set_deferred_uniform(handle.m_index, &value, sizeof(T));
+		}
 
 		void set_uniform_block_binding(uint32_t index, uint32_t binding);
 		void set_uniform_block_binding(std::string_view name, uint32_t binding);
 
+		//Per draw uniform block data. It is streamed into the uniform ring of the engine and bound to binding when the program is applied for a draw.
+		//Draws with such a program are neither batched nor deferred, so the data set before a draw is the data the draw sees
+		void set_uniform_block_data(uint32_t binding, const void* data, size_t size);
+		void clear_uniform_block_data();
+		bool has_uniform_block_data() const;
+		void apply_uniform_block_data() const;
+
+		//Set right away with glProgramUniform, so the bound program doesn't change
 		void set_uniform(int32_t location, float v0) const;
 		void set_uniform(int32_t location, float v0, float v1) const;
 		void set_uniform(int32_t location, float v0, float v1, float v2) const;
@@ -90,10 +159,50 @@ namespace age
 	protected:
 
 	private:
-		inline static thread_local uint32_t m_current_bound_program{};
+		struct uniform_block_data
+		{
+			uint32_t binding = 0;
+			std::vector<uint8_t> data;
+			//Where the data lives in the uniform ring, valid while the ring is in the same generation
+			size_t offset = 0;
+			uint64_t generation = ~uint64_t{ 0 };
+			bool dirty = true;
+		};
+
+		struct deferred_uniform
+		{
+			int32_t location = -1;
+			uint32_t type = 0;
+			//Where the value lives in m_deferred_values
+			uint32_t offset = 0;
+			uint32_t size = 0;
+			bool has_value = false;
+			bool dirty = false;
+		};
+
 		static void delete_handle(uint32_t handle);
 
-		std::vector<uint32_t> m_attached_shaders;
+		//Identifies the program in the program_binary_cache
+		std::string get_cache_description() const;
+		void reflect();
+
+		uint32_t add_deferred_uniform(std::string_view name, uint32_t type, size_t size) const;
+		void set_deferred_uniform(uint32_t index, const void* value, size_t size) const;
+		//Uploads the changed deferred uniforms, the program has to be bound
+		void apply_deferred_uniforms() const;
+
+		std::vector<const shader*> m_attached_shaders;
+		//Part of the key of the program_binary_cache, as the binary contains the locations
+		std::string m_attrib_locations;
+		mutable std::vector<uniform_block_data> m_uniform_block_data;
+
+		name_table<uniform_info> m_uniforms;
+		name_table<uniform_block_info> m_uniform_blocks;
+
+		mutable std::vector<deferred_uniform> m_deferred_uniforms;
+		mutable std::vector<uint8_t> m_deferred_values;
+		mutable bool m_deferred_uniforms_dirty = false;
+
 		unique_handle <uint32_t, delete_handle> m_handle;
 	};
 }
\ No newline at end of file
@@ -29,10 +29,19 @@ namespace age
 
 	public:
 		inline vertex_data get_vertex_data() const { return on_get_vertex_data(); }
+		//Empty if the shape has no outline
+		inline vertex_data get_outline_vertex_data() const { return on_get_outline_vertex_data(); }
+
+		//Includes the outline, which lies outside of the fill
+		float_rect get_local_bounds() const;
+		float_rect get_global_bounds() const;
 
 	protected:
 
 	private:
 		virtual vertex_data on_get_vertex_data() const = 0;
+		virtual vertex_data on_get_outline_vertex_data() const;
+
+		std::optional<float_rect> get_cull_bounds() const override;
 	};
 }
\ No newline at end of file
@@ -6,8 +6,10 @@
 #include <array>
 
 #include "texture.h"
+#include "texture_atlas.h"
 #include "color.h"
 #include "vertex_2d.h"
+#include "mesh_2d.h"
 
 namespace age
 {
@@ -23,17 +25,40 @@ namespace age
 		void set_color(const color& value);
 		const color& get_color() const;
 
-		void set_texture(const texture& value);
+		void set_texture(const texture& value, bool reset_texture_rect = false);
 		const texture& get_texture() const;
 
+		//An empty texture rect shows the whole texture
+		void set_texture_rect(const uint_rect& value);
+		//Uses the page of the region as texture and its rect as texture rect
+		void set_texture_rect(const atlas_region& value);
+		const uint_rect& get_texture_rect() const;
+
+		//Layer which is shown when the texture is a texture_array. It is packed into the texture coordinates, see texture_array::get_layer_offset
+		void set_texture_layer(uint32_t value);
+		uint32_t get_texture_layer() const;
+
+		float_rect get_local_bounds() const;
+		float_rect get_global_bounds() const;
+
+		//Keeps the geometry in a GPU-resident mesh which is only uploaded again after it changed
+		void set_retained(bool value);
+		bool is_retained() const;
+
 	protected:
 
 	private:
 		virtual void draw(render_target& target, const render_states& states) const override;
+		std::optional<float_rect> get_cull_bounds() const override;
 		
 		void update_vertices();
 		
 		const texture* m_texture;
+		uint_rect m_texture_rect;
+		uint32_t m_texture_layer = 0;
 		std::array<vertex_2d, 4> m_vertices;
+
+		mutable retained_mesh m_mesh;
+		bool m_retained = false;
 	};
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "color.h"
 #include "rect.h"
 #include "vertex_2d.h"
+#include "mesh_2d.h"
 
 namespace age
 {
@@ -73,10 +74,15 @@ namespace age
 
 		float_rect get_global_bounds() const;
 
+		//Keeps the geometry in a GPU-resident mesh which is only uploaded again after it changed
+		void set_retained(bool value);
+		bool is_retained() const;
+
 	protected:
 
 	private:
 		void draw(render_target& target, const render_states& states) const override;
+		std::optional<float_rect> get_cull_bounds() const override;
 
 		void ensure_geometry_is_updated() const;
 
@@ -97,5 +103,9 @@ namespace age
 		mutable std::vector<vertex_2d> m_outline_vertices;
 		mutable float_rect m_bounds;
 		mutable bool m_geometry_needs_update;
+
+		mutable retained_mesh m_mesh;
+		mutable retained_mesh m_outline_mesh;
+		bool m_retained = false;
 	};
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <istream>
 
 #include <glm/vec2.hpp>
+#include <glm/mat4x4.hpp>
 #include "rect.h"
 #include "image.h"
 #include "render_window.h"
@@ -15,6 +16,9 @@ namespace age
 	{
 	public:
 		friend class render_target;
+		friend class render_texture;
+		friend class texture_array;
+		friend class readback_service;
 
 		texture();
 		texture(const texture& other);
@@ -23,7 +27,8 @@ namespace age
 		texture& operator = (const texture& other);
 		texture& operator = (texture&& other) = default;
 
-		~texture() = default;
+		//Pending draws which use the texture are submitted before it goes away
+		~texture();
 
 	public:
 		void bind() const;
@@ -34,17 +39,32 @@ namespace age
 		void load(const std::byte data[], std::size_t size, const int_rect& area = int_rect{});
 		void load(std::istream& is, const int_rect& area = int_rect{});
 		void load(const image& img, const int_rect& area = int_rect{});
+		//Uploads a raw_texture container straight from the memory mapped file, including its mipmaps
+		void load_raw(std::string_view filename);
+		void load_raw(const std::byte data[], std::size_t size);
 
 		void update(const uint8_t* pixels);
 		void update(const uint8_t* pixels, const uint_rect& area);
+		//Copies on the GPU, the pixels never go through an image
 		void update(const texture& other_texture);
 		void update(const texture& other_texture, const glm::u32vec2& dest);
+		void update(const texture& other_texture, const uint_rect& area, const glm::u32vec2& dest);
 		void update(const image& img);
 		void update(const image& img, const glm::u32vec2& dest);
-		void update(const render_window& window);
-		void update(const render_window& window, const glm::u32vec2& dest);
+		//Copies the framebuffer of the window after submitting its pending draws, which activates the window.
+		//The framebuffer is stored bottom up, so copying the whole texture flips it and partial copies need a texture which is flipped already.
+		//Throws if the window does not fit at dest or a partial copy targets a texture which is not flipped
+		void update(render_window& window);
+		void update(render_window& window, const glm::u32vec2& dest);
+
+		//Reallocates the storage. With preserve_contents the old pixels are copied on the GPU and stay at the top left
+		void resize(const glm::u32vec2& size, bool preserve_contents = true);
+		//Fills the whole texture on the GPU, no pixels are uploaded
+		void clear(const color& value);
 
 		const glm::uvec2& get_size() const;
+		//Maps pixel coordinates to normalized texture coordinates
+		glm::mat4 get_texture_matrix() const;
 		image copy_to_image() const;
 
 		void set_smooth(bool value);
@@ -60,6 +80,8 @@ namespace age
 		void invalidate_mipmap();
 
 		uint32_t get_id() const;
+		//True for a texture_array, which needs a shader sampling a sampler2DArray
+		bool is_array() const;
 
 		static void bind(const texture* tex);
 		static uint32_t get_maximum_size();
@@ -68,19 +90,28 @@ namespace age
 	private:
 
 		//ToDo: I want to have 1 context per thread, this seems the best solution to share the states between threads
-		inline static thread_local uint32_t m_current_bound_texture;
+
+		explicit texture(uint32_t target);
 
 		static uint32_t gen_handle();
 		static void delete_handle(uint32_t handle);
 
+		//Fallback of update(texture) for textures which are stored flipped or drivers without glCopyImageSubData
+		void blit(const texture& other_texture, const uint_rect& source_area, const uint_rect& dest_area, bool flip);
+
 		uint32_t get_handle() const { return m_handle; }
+		void set_pixels_flipped(bool value);
 
 		glm::uvec2 m_size;
 
 		unique_handle<uint32_t, delete_handle> m_handle;
+		//GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+		uint32_t m_target;
 		bool m_smooth = false;
 		bool m_srgb = false;
 		bool m_repeat = false;
 		bool m_has_mipmap = false;
+		//Framebuffer contents are stored bottom up, so the texture matrix flips them
+		bool m_pixels_flipped = false;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "rect.h"
+#include "image.h"
+#include "texture.h"
+
+namespace age
+{
+	//Layers of equal size in one GL_TEXTURE_2D_ARRAY. The layer is packed into the y texture coordinate of the vertices, see get_layer_offset,
+	//so draws using different layers of the same array can be batched into one draw call.
+	//Needs the texture array shader program of the engine, which sprites select on their own
+	class texture_array
+		: public texture
+	{
+	public:
+		texture_array();
+
+		texture_array(const texture_array& other) = delete;
+		texture_array(texture_array&& other) = default;
+
+		texture_array& operator = (const texture_array& other) = delete;
+		texture_array& operator = (texture_array&& other) = default;
+
+		~texture_array() = default;
+
+	public:
+		//Creates num_layers layers with undefined contents
+		void create(const glm::u32vec2& size, uint32_t num_layers);
+		//Creates one layer per image. All images need to have the same size
+		void load(const std::vector<image>& images);
+
+		//Appends a layer and returns its index. The storage is reallocated when it is full.
+		//An empty array takes the size of the image, otherwise the sizes have to match
+		uint32_t add_layer(const image& img);
+		//Appends the images as consecutive layers and returns the index of the first one
+		uint32_t add_layers(const std::vector<image>& images);
+		//Makes sure num_layers layers fit without further reallocations
+		void reserve(uint32_t num_layers);
+
+		void update(uint32_t layer, const uint8_t* pixels);
+		void update(uint32_t layer, const uint8_t* pixels, const uint_rect& area);
+		void update(uint32_t layer, const image& img);
+		void update(uint32_t layer, const image& img, const glm::u32vec2& dest);
+
+		uint32_t get_num_layers() const;
+		uint32_t get_capacity() const;
+
+		//Added to the y texture coordinates in pixels to select the layer. Layers are twice the layer height apart,
+		//so texture rects have to stay within one layer
+		float get_layer_offset(uint32_t layer) const;
+
+		image copy_to_image(uint32_t layer) const;
+
+		static uint32_t get_maximum_layers();
+
+	protected:
+
+	private:
+		//Moves the existing layers into new storage for capacity layers
+		void reallocate(uint32_t capacity);
+		//Limited by GL and by the packed texture coordinates, which have to stay exact in single precision
+		uint32_t get_layer_limit() const;
+		void check_size(const glm::u32vec2& size, const char* message) const;
+
+		uint32_t m_num_layers = 0;
+		uint32_t m_capacity = 0;
+	};
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <optional>
+
+#include <glm/vec2.hpp>
+
+#include "rect.h"
+#include "image.h"
+#include "texture.h"
+
+namespace age
+{
+	//Part of a texture_atlas page. Stays valid until the atlas is cleared or destroyed
+	struct atlas_region
+	{
+		const texture* page = nullptr;
+		uint_rect rect;
+
+		inline bool is_valid() const { return page != nullptr; }
+	};
+
+	//Packs images at runtime into one or more texture pages with a skyline bottom left packer.
+	//Inserting never moves entries which have already been packed, new pages are added when the existing ones are full.
+	class texture_atlas
+	{
+	public:
+		texture_atlas(const glm::u32vec2& page_size = glm::u32vec2{ 2048, 2048 }, uint32_t padding = 1, uint32_t extrusion = 1);
+
+		texture_atlas(const texture_atlas& other) = delete;
+		texture_atlas(texture_atlas&& other) = default;
+
+		texture_atlas& operator = (const texture_atlas& other) = delete;
+		texture_atlas& operator = (texture_atlas&& other) = default;
+
+	public:
+		//Throws if the image including twice the extrusion and the padding is larger than a page
+		atlas_region insert(const image& img);
+		atlas_region insert(const image& img, const uint_rect& area);
+
+		void clear();
+
+		size_t get_num_pages() const;
+		const texture& get_page(size_t index) const;
+
+		const glm::u32vec2& get_page_size() const;
+		uint32_t get_padding() const;
+		uint32_t get_extrusion() const;
+
+		void set_smooth(bool value);
+		bool get_smooth() const;
+
+	protected:
+
+	private:
+		struct skyline_node
+		{
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+		};
+
+		struct page
+		{
+			texture tex;
+			std::vector<skyline_node> skyline;
+		};
+
+		struct placement
+		{
+			size_t node_index;
+			glm::u32vec2 position;
+		};
+
+		std::optional<uint32_t> fit(const page& p, size_t node_index, const glm::u32vec2& size) const;
+		std::optional<placement> find_placement(const page& p, const glm::u32vec2& size) const;
+		void add_skyline_level(page& p, const placement& place, const glm::u32vec2& size);
+		page& add_page();
+
+		glm::u32vec2 m_page_size;
+		uint32_t m_padding;
+		uint32_t m_extrusion;
+		bool m_smooth = false;
+
+		//A deque keeps the page textures at their addresses when new pages are added
+		std::deque<page> m_pages;
+		std::vector<uint8_t> m_scratch;
+	};
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "image.h"
+#include "texture.h"
+
+namespace age
+{
+	//Loads textures on a dedicated thread which owns a shared GL context, so decoding and uploading never stall the frames of the calling thread.
+	//Pixels are streamed through a pool of pixel unpack buffers and every upload is guarded by a fence.
+	//The future of an upload becomes ready once the GPU has finished it. Until then the texture must neither be used nor destroyed.
+	//Needs to be created and destroyed on the thread of the engine
+	class texture_upload_service
+	{
+	public:
+		texture_upload_service(size_t num_pixel_buffers = 4);
+		~texture_upload_service();
+
+		texture_upload_service(const texture_upload_service& other) = delete;
+		texture_upload_service(texture_upload_service&& other) = delete;
+
+		texture_upload_service& operator = (const texture_upload_service& other) = delete;
+		texture_upload_service& operator = (texture_upload_service&& other) = delete;
+
+	public:
+		//Decodes the file on the upload thread. A failed load is reported by the future
+		std::shared_future<void> load(texture& tex, std::string_view filename);
+		std::shared_future<void> load(texture& tex, std::vector<std::byte> data);
+		std::shared_future<void> load(texture& tex, image img);
+
+		//Uploads which have been requested but are not finished yet
+		size_t get_num_pending_uploads() const;
+
+	protected:
+
+	private:
+		struct upload_job
+		{
+			texture* target;
+			std::function<image()> decode;
+			std::promise<void> promise;
+		};
+
+		struct pending_upload
+		{
+			void* fence;
+			std::promise<void> promise;
+			size_t pixel_buffer;
+		};
+
+		struct pixel_buffer
+		{
+			uint32_t id = 0;
+			size_t capacity = 0;
+		};
+
+		std::shared_future<void> add_job(texture& tex, std::function<image()> decode);
+
+		void work();
+		void upload(upload_job& job);
+		//Resolves the futures of the finished uploads. With wait it blocks until at least the oldest one finished
+		void retire_uploads(bool wait);
+		void retire_oldest_upload();
+
+		std::vector<pixel_buffer> m_pixel_buffers;
+		size_t m_next_pixel_buffer = 0;
+		//Only touched by the upload thread
+		std::deque<pending_upload> m_pending_uploads;
+
+		std::thread m_thread;
+		std::condition_variable m_queue_pending;
+		mutable std::mutex m_queue_mutex;
+		std::deque<upload_job> m_job_queue;
+		std::atomic<size_t> m_num_pending_uploads{ 0 };
+
+		bool m_exit = false;
+	};
+}
@@ -3,6 +3,8 @@
 #include <glm/vec2.hpp>
 #include <glm/mat4x4.hpp>
 
+#include "rect.h"
+
 namespace age
 {
 	class transformable_2d
@@ -50,4 +52,7 @@ namespace age
 		mutable bool m_transform_needs_update;
 		mutable bool m_inverse_transform_needs_update;
 	};
+
+	//Axis aligned bounding box of the transformed rect
+	float_rect transform_rect(const glm::mat4& transform, const float_rect& rect);
 }
\ No newline at end of file
@@ -22,8 +22,6 @@ namespace age
 	protected:
 
 	private:
-		inline static thread_local uint32_t m_current_bound_uniform_buffer_object{};
-
 		static uint32_t gen_handle();
 		static void delete_handle(uint32_t handle);
 
@@ -35,4 +35,7 @@ namespace age
 		color color;
 		glm::vec2 tex_coords;
 	};
+
+	//The vertex layout in engine::set_vertex_2d_attributes and the SIMD kernels depend on this
+	static_assert(sizeof(vertex_2d) == 20, "vertex_2d needs to be tightly packed");
 }
\ No newline at end of file
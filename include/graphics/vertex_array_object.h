@@ -17,8 +17,6 @@ namespace age
 	protected:
 
 	private:
-		inline static uint32_t m_current_bound_array;
-
 		uint32_t get_handle() const { return m_handle; }
 
 		static uint32_t create_handle();
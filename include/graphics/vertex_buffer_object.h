@@ -14,6 +14,9 @@ namespace age
 		{
 			array = 0,
 			element_array,
+			draw_indirect,
+			shader_storage,
+			uniform,
 
 			num_elements
 		};
@@ -26,25 +29,55 @@ namespace age
 		};
 
 		vertex_buffer_object(target target);
+		~vertex_buffer_object();
 
 	public:
 		inline void set_target(target value) noexcept { m_target = value; }
 		inline target get_target() const noexcept{ return m_target; }
 
 		void bind() const;
+		//Binds a range of the buffer to an indexed binding point. Only valid for shader_storage and uniform buffers
+		void bind_range(uint32_t index, size_t offset, size_t size_in_bytes) const;
 		
 		void buffer_data(const void* data, size_t size_in_bytes, usage usage);
 		void update_data(const void* data, size_t size_in_bytes, usage usage);
 		void buffer_sub_data(const void* data, size_t offset, size_t size_in_bytes);
 
+		//Turns the buffer into a ring of stream_regions regions which are sub-allocated by stream_data
+		void create_stream(size_t region_size_in_bytes);
+		//Copies data into the ring and returns its offset in bytes from the start of the buffer
+		size_t stream_data(const void* data, size_t size_in_bytes, size_t alignment);
+		inline bool is_streaming() const noexcept { return m_stream.region_size != 0; }
+		//Counts up every time the ring moves on to the next region or its storage is reallocated. Ranges which were streamed in an older generation may be overwritten soon
+		inline uint64_t get_stream_generation() const noexcept { return m_stream.generation; }
+
+		uint32_t get_id() const;
+
+		static constexpr size_t stream_regions = 3;
+
 	protected:
 
 	private:
+		struct stream_state
+		{
+			size_t region_size{};
+			size_t region{};
+			size_t offset{};
+
+			std::array<void*, stream_regions> fences{};
+			uint8_t* mapped_data{};
+			bool persistent{};
+			uint64_t generation{};
+		};
+
 		static uint32_t convert_target(target target_to_convert);
 		static uint32_t convert_usage(usage usage_to_convert);
 
-		inline static std::array<uint32_t, static_cast<uint32_t>(target::num_elements)> m_current_bound_buffer{0};
-		//inline static uint32_t m_current_bound_buffer[target::num_elements];
+		void allocate_stream_storage();
+		void release_stream_storage();
+		void next_stream_region();
+		void write_stream_data(const void* data, size_t offset, size_t size_in_bytes);
+		void record_upload(size_t size_in_bytes) const;
 
 		uint32_t get_handle() const { return m_handle; }
 
@@ -57,6 +90,8 @@ namespace age
 		std::array<size_t, static_cast<uint32_t>(target::num_elements)> m_last_buffer_size{0};
 		std::array<usage, static_cast<uint32_t>(target::num_elements)> m_last_buffer_usage{usage::static_draw};
 
+		stream_state m_stream;
+
 		//size_t m_last_buffer_size{};
 		//usage m_last_buffer_usage = usage::static_draw;
 	};
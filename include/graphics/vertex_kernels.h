@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/mat4x4.hpp>
+
+#include "vertex_2d.h"
+#include "color.h"
+
+namespace age
+{
+	//Kernels over arrays of vertex_2d. The implementation is picked once at runtime, AVX2 and SSE2 on x86, NEON on ARM and scalar code elsewhere.
+	//All implementations produce the same results as the scalar code
+
+	//Applies the 2D affine part of transform to the positions
+	void transform_positions(vertex_2d vertices[], size_t count, const glm::mat4& transform);
+
+	void set_colors(vertex_2d vertices[], size_t count, const color& value);
+
+	//Name of the instruction set the kernels run with, e.g. "avx2"
+	const char* get_vertex_kernels_isa();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace age
+{
+	//Read only view of a whole file. The file is mapped into memory where the platform supports it, otherwise it is read into memory
+	class mapped_file
+	{
+	public:
+		mapped_file() = default;
+		mapped_file(std::string_view fn);
+		~mapped_file();
+
+		mapped_file(const mapped_file& other) = delete;
+		mapped_file(mapped_file&& other) noexcept;
+
+		mapped_file& operator = (const mapped_file& other) = delete;
+		mapped_file& operator = (mapped_file&& other) noexcept;
+
+	public:
+		void open(std::string_view fn);
+		void close();
+
+		bool is_open() const;
+
+		const std::byte* get_data() const;
+		size_t get_size() const;
+
+	protected:
+
+	private:
+		const std::byte* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_mapped = false;
+
+		//Contents of the file on platforms without memory mapping
+		std::vector<std::byte> m_buffer;
+	};
+}
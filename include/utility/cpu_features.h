@@ -0,0 +1,27 @@
+#pragma once
+
+//Instruction sets the SIMD kernels are compiled for. SSE2 is part of every x86-64 CPU, AVX2 code is compiled per function
+//with AGE_TARGET_AVX2 and only called after has_avx2() returned true. NEON is part of every ARMv8 CPU
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define AGE_SIMD_X86
+	#include <immintrin.h>
+
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define AGE_TARGET_AVX2
+	#else
+		#define AGE_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define AGE_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace age
+{
+	namespace cpu_features
+	{
+		//Also checks that the OS saves the YMM registers. Always false on other architectures than x86
+		bool has_avx2();
+	}
+}
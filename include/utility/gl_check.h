@@ -1,8 +1,12 @@
 #pragma once
 
 #include <iostream>
+#include <cstdint>
 #include <glad/glad.h>
 
+//Number of glGetError calls made by GL_CALL on this thread, read by the render statistics
+inline thread_local uint64_t gl_error_check_count = 0;
+
 #ifndef NDEBUG
 inline const char* gl_error_string(GLenum err)
 {
@@ -20,6 +24,8 @@ inline const char* gl_error_string(GLenum err)
 
 inline void gl_check_errors(const char* expr, const char* file, int line)
 {
+    ++gl_error_check_count;
+
     if (GLenum err; (err = glGetError()) != GL_NO_ERROR)
     {
         std::cerr << "[OpenGL Error] " << gl_error_string(err)
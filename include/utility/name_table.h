@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace age
+{
+	//Open addressing hash table from names to values, built once and then only read, e.g. the reflected uniforms of a shader_program.
+	//All names share one string, so looking up a std::string_view never allocates.
+	template <typename T>
+	class name_table
+	{
+	public:
+		void clear()
+		{
+			m_entries.clear();
+			m_names.clear();
+			m_size = 0;
+		}
+
+		//Replaces the value if the name is already in the table
+		void insert(std::string_view name, const T& value)
+		{
+			//Keeps the load factor at 1/2 at most, so probe sequences stay short
+			if ((m_size + 1) * 2 > m_entries.size())
+				rehash(m_entries.empty() ? 16 : m_entries.size() * 2);
+
+			uint32_t hash = hash_name(name);
+			entry& slot = m_entries[find_slot(name, hash)];
+
+			if (slot.name_length == 0)
+			{
+				slot.hash = hash;
+				slot.name_offset = static_cast<uint32_t>(m_names.size());
+				slot.name_length = static_cast<uint32_t>(name.size());
+				m_names.append(name);
+				++m_size;
+			}
+
+			slot.value = value;
+		}
+
+		const T* find(std::string_view name) const
+		{
+			if (m_entries.empty() || name.empty())
+				return nullptr;
+
+			const entry& slot = m_entries[find_slot(name, hash_name(name))];
+			return slot.name_length != 0 ? &slot.value : nullptr;
+		}
+
+		size_t size() const { return m_size; }
+
+	protected:
+
+	private:
+		//Empty slots have a name_length of 0, empty names are never stored
+		struct entry
+		{
+			uint32_t hash = 0;
+			uint32_t name_offset = 0;
+			uint32_t name_length = 0;
+			T value{};
+		};
+
+		//FNV-1a
+		static uint32_t hash_name(std::string_view name)
+		{
+			uint32_t hash = 2166136261u;
+			for (char c : name)
+			{
+				hash ^= static_cast<uint8_t>(c);
+				hash *= 16777619u;
+			}
+
+			return hash;
+		}
+
+		//Index of the slot of the name, or of the empty slot where it would be inserted
+		size_t find_slot(std::string_view name, uint32_t hash) const
+		{
+			size_t mask = m_entries.size() - 1;
+
+			for (size_t index = hash & mask;; index = (index + 1) & mask)
+			{
+				const entry& slot = m_entries[index];
+
+				if (slot.name_length == 0)
+					return index;
+
+				if (slot.hash == hash && std::string_view{ m_names.data() + slot.name_offset, slot.name_length } == name)
+					return index;
+			}
+		}
+
+		void rehash(size_t capacity)
+		{
+			std::vector<entry> entries(capacity);
+			entries.swap(m_entries);
+
+			size_t mask = capacity - 1;
+
+			for (auto& old_entry : entries)
+			{
+				if (old_entry.name_length == 0)
+					continue;
+
+				size_t index = old_entry.hash & mask;
+				while (m_entries[index].name_length != 0)
+					index = (index + 1) & mask;
+
+				m_entries[index] = std::move(old_entry);
+			}
+		}
+
+		//The size is always a power of two
+		std::vector<entry> m_entries;
+		std::string m_names;
+		size_t m_size = 0;
+	};
+}
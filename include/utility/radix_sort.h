@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <utility>
+
+namespace age
+{
+	struct radix_sort_item
+	{
+		uint64_t key;
+		uint32_t value;
+	};
+
+	//Stable LSD radix sort over 64 bit keys, one byte per pass. Passes in which all keys share the same byte are skipped.
+	//scratch is resized to the size of items and can be reused between calls to avoid allocations.
+	inline void radix_sort(std::vector<radix_sort_item>& items, std::vector<radix_sort_item>& scratch)
+	{
+		size_t size = items.size();
+		if (size < 2)
+			return;
+
+		scratch.resize(size);
+
+		std::array<std::array<size_t, 256>, 8> histograms{};
+
+		for (const auto& item : items)
+			for (size_t pass = 0; pass < 8; ++pass)
+				++histograms[pass][(item.key >> (pass * 8)) & 0xff];
+
+		auto* source = &items;
+		auto* destination = &scratch;
+
+		for (size_t pass = 0; pass < 8; ++pass)
+		{
+			auto& histogram = histograms[pass];
+			auto shift = pass * 8;
+
+			if (histogram[((*source)[0].key >> shift) & 0xff] == size)
+				continue;
+
+			size_t offset = 0;
+			for (auto& count : histogram)
+			{
+				auto current = count;
+				count = offset;
+				offset += current;
+			}
+
+			for (const auto& item : *source)
+				(*destination)[histogram[(item.key >> shift) & 0xff]++] = item;
+
+			std::swap(source, destination);
+		}
+
+		if (source != &items)
+			items.swap(scratch);
+	}
+}
@@ -105,6 +105,10 @@ namespace age
 
 	int32_t engine::init_lib(uint32_t flags)
 	{
+		//The offscreen driver creates its GL contexts through EGL, which also works without a display, e.g. with Mesa llvmpipe
+		if (render_window::get_headless_request())
+			SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+
 		return SDL_Init(flags);
 	}
 
@@ -113,6 +117,21 @@ namespace age
 		SDL_Quit();
 	}
 
+	inline bool has_GL_extension(std::string_view name)
+	{
+		GLint num_extensions = 0;
+		GL_CALL(glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions));
+
+		for (GLint i = 0; i < num_extensions; ++i)
+		{
+			auto extension = reinterpret_cast<const char*>(GL_CALL(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))));
+			if (extension && name == extension)
+				return true;
+		}
+
+		return false;
+	}
+
 	void engine::init_defaults()
 	{
 		std::string_view vertex_shader_source =
@@ -167,6 +186,187 @@ namespace age
 		m_default_shader_program.bind_attrib_location(get_a_tex_coords_index(), "a_uv");
 		m_default_shader_program.link();
 
+		//Variant of the default vertex shader for instanced_sprite_batch. Every instance expands the unit quad by its own transform and texture rect
+		std::string_view instanced_vertex_shader_source =
+			"#version 330 core\n"
+			"precision mediump float;\n"
+			"layout (std140) uniform viewprojection_matrix\n"
+			"{\n"
+			"	mat4 vp_m;\n"
+			"};\n"
+			"layout (std140) uniform model_matrix\n"
+			"{\n"
+			"	mat4 model_m;\n"
+			"};\n"
+			"layout (std140) uniform texture_matrices\n"
+			"{\n"
+			"	mat4 tex_m;\n"
+			"};\n"
+			"in vec2 a_position;\n"
+			"in vec4 a_color;\n"
+			"in vec2 a_uv;\n"
+			"in vec2 i_position;\n"
+			"in vec2 i_origin;\n"
+			"in vec2 i_scale;\n"
+			"in float i_rotation;\n"
+			"in vec4 i_color;\n"
+			"in vec4 i_texture_rect;\n"
+			"out vec4 v_color;\n"
+			"out vec2 v_uv;\n"
+			"void main()\n"
+			"{\n"
+			"	vec2 local = (a_position * i_texture_rect.zw - i_origin) * i_scale;\n"
+			"	float angle = radians(i_rotation);\n"
+			"	float c = cos(angle);\n"
+			"	float s = sin(angle);\n"
+			"	vec2 world = vec2(c * local.x - s * local.y, s * local.x + c * local.y) + i_position;\n"
+			"	gl_Position = vp_m * model_m * vec4(world, 0.0, 1.0);\n"
+			"	v_color = a_color * i_color;\n"
+			"	vec4 t_coords = tex_m * vec4(i_texture_rect.xy + a_uv * i_texture_rect.zw, 0.0, 1.0);\n"
+			"	v_uv = t_coords.xy;\n"
+			"}";
+
+		m_instanced_vertex_shader.compile(instanced_vertex_shader_source);
+
+		m_instanced_shader_program.attach_shader(m_instanced_vertex_shader);
+		m_instanced_shader_program.attach_shader(m_default_fragment_shader);
+		m_instanced_shader_program.bind_attrib_location(get_a_position_index(), "a_position");
+		m_instanced_shader_program.bind_attrib_location(get_a_color_index(), "a_color");
+		m_instanced_shader_program.bind_attrib_location(get_a_tex_coords_index(), "a_uv");
+		m_instanced_shader_program.bind_attrib_location(get_i_position_index(), "i_position");
+		m_instanced_shader_program.bind_attrib_location(get_i_origin_index(), "i_origin");
+		m_instanced_shader_program.bind_attrib_location(get_i_scale_index(), "i_scale");
+		m_instanced_shader_program.bind_attrib_location(get_i_rotation_index(), "i_rotation");
+		m_instanced_shader_program.bind_attrib_location(get_i_color_index(), "i_color");
+		m_instanced_shader_program.bind_attrib_location(get_i_texture_rect_index(), "i_texture_rect");
+		m_instanced_shader_program.link();
+
+		//Variant of the default shaders for texture_array. The layer is packed into the y texture coordinate with a stride of twice the layer height,
+		//see texture_array::get_layer_offset. It is unpacked per vertex and passed through flat, so it is never interpolated
+		std::string_view texture_array_vertex_shader_source =
+			"#version 330 core\n"
+			"precision mediump float;\n"
+			"layout (std140) uniform viewprojection_matrix\n"
+			"{\n"
+			"	mat4 vp_m;\n"
+			"};\n"
+			"layout (std140) uniform model_matrix\n"
+			"{\n"
+			"	mat4 model_m;\n"
+			"};\n"
+			"layout (std140) uniform texture_matrices\n"
+			"{\n"
+			"	mat4 tex_m;\n"
+			"};\n"
+			"uniform sampler2DArray u_texture;\n"
+			"in vec2 a_position;\n"
+			"in vec4 a_color;\n"
+			"in vec2 a_uv;\n"
+			"out vec4 v_color;\n"
+			"out vec2 v_uv;\n"
+			"flat out float v_tex_layer;\n"
+			"void main()\n"
+			"{\n"
+			"	gl_Position = vp_m * model_m * vec4(a_position, 0.0, 1.0);\n"
+			"	v_color = a_color;\n"
+			"	float layer_stride = float(2 * textureSize(u_texture, 0).y);\n"
+			"	float layer = floor(a_uv.y / layer_stride);\n"
+			"	vec4 t_coords = tex_m * vec4(a_uv.x, a_uv.y - layer * layer_stride, 0.0, 1.0);\n"
+			"	v_uv = t_coords.xy;\n"
+			"	v_tex_layer = layer;\n"
+			"}";
+
+		std::string_view texture_array_fragment_shader_source =
+			"#version 330 core\n"
+			"precision mediump float;\n"
+			"uniform sampler2DArray u_texture;\n"
+			"in vec4 v_color;\n"
+			"in vec2 v_uv;\n"
+			"flat in float v_tex_layer;\n"
+			"out vec4 frag_color;\n"
+			"void main()\n"
+			"{\n"
+			"	vec4 texel = texture(u_texture, vec3(v_uv, v_tex_layer));\n"
+			"	if(texel.a == 0.0) discard;\n"
+			"	frag_color = v_color * texel;\n"
+			"}";
+
+		m_texture_array_vertex_shader.compile(texture_array_vertex_shader_source);
+		m_texture_array_fragment_shader.compile(texture_array_fragment_shader_source);
+
+		m_texture_array_shader_program.attach_shader(m_texture_array_vertex_shader);
+		m_texture_array_shader_program.attach_shader(m_texture_array_fragment_shader);
+		m_texture_array_shader_program.bind_attrib_location(get_a_position_index(), "a_position");
+		m_texture_array_shader_program.bind_attrib_location(get_a_color_index(), "a_color");
+		m_texture_array_shader_program.bind_attrib_location(get_a_tex_coords_index(), "a_uv");
+		m_texture_array_shader_program.link();
+
+		m_shader_draw_parameters = has_GL_extension("GL_ARB_shader_draw_parameters");
+
+		//glad only loads glBufferStorage for GL 4.4 contexts, on the default 4.3 context it comes from the extension
+		m_buffer_storage = GLAD_GL_VERSION_4_4;
+		if (!m_buffer_storage && has_GL_extension("GL_ARB_buffer_storage"))
+		{
+			glad_glBufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(SDL_GL_GetProcAddress("glBufferStorage"));
+			m_buffer_storage = glad_glBufferStorage != nullptr;
+		}
+
+		GLint shader_storage_offset_alignment = 0;
+		GL_CALL(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &shader_storage_offset_alignment));
+		if (shader_storage_offset_alignment > 0)
+			m_shader_storage_offset_alignment = static_cast<size_t>(shader_storage_offset_alignment);
+
+		GLint uniform_buffer_offset_alignment = 0;
+		GL_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_offset_alignment));
+		if (uniform_buffer_offset_alignment > 0)
+			m_uniform_buffer_offset_alignment = static_cast<size_t>(uniform_buffer_offset_alignment);
+
+		if (m_shader_draw_parameters)
+		{
+			//Variant of the default vertex shader for multi draw indirect batches. The model matrix of every draw is looked up by its draw id
+			std::string_view indirect_vertex_shader_source =
+				"#version 430 core\n"
+				"#extension GL_ARB_shader_draw_parameters : require\n"
+				"precision mediump float;\n"
+				"layout (std140) uniform viewprojection_matrix\n"
+				"{\n"
+				"	mat4 vp_m;\n"
+				"};\n"
+				"layout (std140) uniform texture_matrices\n"
+				"{\n"
+				"	mat4 tex_m;\n"
+				"};\n"
+				"layout (std430, binding = 0) readonly buffer draw_transforms\n"
+				"{\n"
+				"	mat4 model_m[];\n"
+				"};\n"
+				"in vec2 a_position;\n"
+				"in vec4 a_color;\n"
+				"in vec2 a_uv;\n"
+				"out vec4 v_color;\n"
+				"out vec2 v_uv;\n"
+				"void main()\n"
+				"{\n"
+				"	gl_Position = vp_m * model_m[gl_DrawIDARB] * vec4(a_position, 0.0, 1.0);\n"
+				"	v_color = a_color;\n"
+				"	vec4 t_coords = tex_m * vec4(a_uv, 0.0, 1.0);\n"
+				"	v_uv = t_coords.xy;\n"
+				"}";
+
+			m_indirect_vertex_shader.compile(indirect_vertex_shader_source);
+
+			m_indirect_shader_program.attach_shader(m_indirect_vertex_shader);
+			m_indirect_shader_program.attach_shader(m_default_fragment_shader);
+			m_indirect_shader_program.bind_attrib_location(get_a_position_index(), "a_position");
+			m_indirect_shader_program.bind_attrib_location(get_a_color_index(), "a_color");
+			m_indirect_shader_program.bind_attrib_location(get_a_tex_coords_index(), "a_uv");
+			m_indirect_shader_program.link();
+
+			m_indirect_shader_program.set_uniform("u_texture", 0);
+			m_indirect_shader_program.set_uniform_block_binding("viewprojection_matrix", get_vp_matrix_binding());
+			m_indirect_shader_program.set_uniform_block_binding("texture_matrices", get_texture_matrix_binding());
+		}
+
 		/*
 		ToDo: later on gon with this approach. Have all the matrices separated and have 3 UBOs
 		layout(std140) uniform MVP {
@@ -189,12 +389,25 @@ namespace age
 		m_default_shader_program.set_uniform_block_binding("model_matrix", get_model_matrix_binding());
 		m_default_shader_program.set_uniform_block_binding("texture_matrices", get_texture_matrix_binding());
 
+		m_instanced_shader_program.set_uniform("u_texture", 0);
+		m_instanced_shader_program.set_uniform_block_binding("viewprojection_matrix", get_vp_matrix_binding());
+		m_instanced_shader_program.set_uniform_block_binding("model_matrix", get_model_matrix_binding());
+		m_instanced_shader_program.set_uniform_block_binding("texture_matrices", get_texture_matrix_binding());
+
+		m_texture_array_shader_program.set_uniform("u_texture", 0);
+		m_texture_array_shader_program.set_uniform_block_binding("viewprojection_matrix", get_vp_matrix_binding());
+		m_texture_array_shader_program.set_uniform_block_binding("model_matrix", get_model_matrix_binding());
+		m_texture_array_shader_program.set_uniform_block_binding("texture_matrices", get_texture_matrix_binding());
+
 		m_default_texture.create(glm::u32vec2{ 1, 1 });
 		m_default_texture.update(std::array<uint8_t, 4>{255, 255, 255, 255}.data());
 
 		m_default_vertex_array_object.bind();
-		m_default_vertex_buffer_object.bind();
-		m_default_element_buffer_object.bind();
+		m_default_vertex_buffer_object.create_stream(get_vertex_stream_region_size());
+		m_default_element_buffer_object.create_stream(get_element_stream_region_size());
+		m_draw_indirect_buffer_object.create_stream(get_draw_indirect_stream_region_size());
+		m_draw_transform_buffer_object.create_stream(get_draw_transform_stream_region_size());
+		m_uniform_stream_buffer_object.create_stream(get_uniform_stream_region_size());
 
 		m_vp_matrix_ubo.buffer_data(sizeof(glm::mat4x4), glm::value_ptr(glm::mat4{ 1.0f }));
 		m_model_matrix_ubo.buffer_data(sizeof(glm::mat4x4), glm::value_ptr(glm::mat4{ 1.0f }));
@@ -206,6 +419,21 @@ namespace age
 		m_model_matrix_ubo.bind_buffer_base(get_model_matrix_binding());
 		m_texture_matrix_ubo.bind_buffer_base(get_texture_matrix_binding());
 
+		apply_default_vertex_layout();
+		
+		//m_default_vertex_array_object.release();
+	}
+
+	void engine::apply_default_vertex_layout()
+	{
+		m_default_vertex_array_object.bind();
+		m_default_vertex_buffer_object.bind();
+
+		set_vertex_2d_attributes();
+	}
+
+	void engine::set_vertex_2d_attributes()
+	{
 		GL_CALL(glEnableVertexAttribArray(get_a_position_index()));
 		GL_CALL(glEnableVertexAttribArray(get_a_color_index()));
 		GL_CALL(glEnableVertexAttribArray(get_a_tex_coords_index()));
@@ -213,8 +441,6 @@ namespace age
 		GL_CALL(glVertexAttribPointer(get_a_position_index(), 2, GL_FLOAT, GL_FALSE, sizeof(vertex_2d), reinterpret_cast<void*>(0)));
 		GL_CALL(glVertexAttribPointer(get_a_color_index(), 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex_2d), reinterpret_cast<void*>(8)));
 		GL_CALL(glVertexAttribPointer(get_a_tex_coords_index(), 2, GL_FLOAT, GL_FALSE, sizeof(vertex_2d), reinterpret_cast<void*>(12)));
-		
-		//m_default_vertex_array_object.release();
 	}
 
 	engine::app_result engine::user_create()
@@ -0,0 +1,464 @@
+#include "graphics/aabb_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include <glm/common.hpp>
+
+#include "graphics/view_2d.h"
+#include "graphics/transformable_2d.h"
+
+namespace age
+{
+	//How far ahead of the displacement the fat bounds of a moving proxy reach
+	constexpr float displacement_multiplier = 2.0f;
+
+	aabb_tree::aabb_tree(float margin)
+		: m_root{ null_node }
+		, m_free_list{ null_node }
+		, m_size{ 0 }
+		, m_margin{ margin }
+	{}
+
+	aabb_tree::proxy_id aabb_tree::insert(const float_rect& bounds, void* user_data)
+	{
+		int32_t proxy = allocate_node();
+
+		box tight = to_box(bounds);
+		m_nodes[proxy].bounds = box{ tight.min - glm::vec2{ m_margin }, tight.max + glm::vec2{ m_margin } };
+		m_nodes[proxy].user_data = user_data;
+		m_nodes[proxy].height = 0;
+
+		insert_leaf(proxy);
+		++m_size;
+
+		return proxy;
+	}
+
+	void aabb_tree::remove(proxy_id proxy)
+	{
+		assert(proxy >= 0 && proxy < static_cast<proxy_id>(m_nodes.size()) && m_nodes[proxy].is_leaf());
+
+		remove_leaf(proxy);
+		free_node(proxy);
+		--m_size;
+	}
+
+	bool aabb_tree::move(proxy_id proxy, const float_rect& bounds, const glm::vec2& displacement)
+	{
+		assert(proxy >= 0 && proxy < static_cast<proxy_id>(m_nodes.size()) && m_nodes[proxy].is_leaf());
+
+		box tight = to_box(bounds);
+		box fat{ tight.min - glm::vec2{ m_margin }, tight.max + glm::vec2{ m_margin } };
+
+		glm::vec2 ahead = displacement * displacement_multiplier;
+		fat.min = glm::min(fat.min, fat.min + ahead);
+		fat.max = glm::max(fat.max, fat.max + ahead);
+
+		const box& current = m_nodes[proxy].bounds;
+		if (contains(current, tight))
+		{
+			//Fat bounds which became much larger than needed, e.g. after a fast movement, make queries report too much
+			box huge{ fat.min - glm::vec2{ 4.0f * m_margin }, fat.max + glm::vec2{ 4.0f * m_margin } };
+			if (contains(huge, current))
+				return false;
+		}
+
+		remove_leaf(proxy);
+		m_nodes[proxy].bounds = fat;
+		insert_leaf(proxy);
+
+		return true;
+	}
+
+	void aabb_tree::clear()
+	{
+		m_nodes.clear();
+		m_root = null_node;
+		m_free_list = null_node;
+		m_size = 0;
+	}
+
+	void aabb_tree::rebuild()
+	{
+		std::vector<int32_t> leaves;
+		leaves.reserve(m_size);
+
+		for (int32_t i = 0; i < static_cast<int32_t>(m_nodes.size()); ++i)
+		{
+			auto& current = m_nodes[i];
+
+			if (current.height < 0)
+				continue;
+
+			if (current.is_leaf())
+			{
+				current.parent = null_node;
+				leaves.push_back(i);
+			}
+			else
+			{
+				free_node(i);
+			}
+		}
+
+		m_root = leaves.empty() ? null_node : build(leaves.data(), leaves.data() + leaves.size());
+		if (m_root != null_node)
+			m_nodes[m_root].parent = null_node;
+	}
+
+	void* aabb_tree::get_user_data(proxy_id proxy) const
+	{
+		return m_nodes[proxy].user_data;
+	}
+
+	float_rect aabb_tree::get_fat_bounds(proxy_id proxy) const
+	{
+		return to_rect(m_nodes[proxy].bounds);
+	}
+
+	size_t aabb_tree::get_size() const
+	{
+		return m_size;
+	}
+
+	int32_t aabb_tree::get_height() const
+	{
+		return m_root == null_node ? 0 : m_nodes[m_root].height;
+	}
+
+	float_rect aabb_tree::get_view_bounds(const view_2d& view)
+	{
+		//The view transform maps the visible area onto the clip space square
+		return transform_rect(view.get_inverse_transform(), float_rect{ glm::vec2{ -1.0f, -1.0f }, glm::vec2{ 2.0f, 2.0f } });
+	}
+
+	aabb_tree::box aabb_tree::to_box(const float_rect& rect)
+	{
+		glm::vec2 a{ rect.left, rect.top };
+		glm::vec2 b{ rect.left + rect.width, rect.top + rect.height };
+
+		return box{ glm::min(a, b), glm::max(a, b) };
+	}
+
+	float_rect aabb_tree::to_rect(const box& value)
+	{
+		return float_rect{ value.min, value.max - value.min };
+	}
+
+	aabb_tree::box aabb_tree::combine(const box& a, const box& b)
+	{
+		return box{ glm::min(a.min, b.min), glm::max(a.max, b.max) };
+	}
+
+	float aabb_tree::get_perimeter(const box& value)
+	{
+		glm::vec2 size = value.max - value.min;
+
+		return 2.0f * (size.x + size.y);
+	}
+
+	bool aabb_tree::contains(const box& outer, const box& inner)
+	{
+		return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y
+			&& inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+	}
+
+	int32_t aabb_tree::allocate_node()
+	{
+		int32_t index;
+
+		if (m_free_list != null_node)
+		{
+			index = m_free_list;
+			m_free_list = m_nodes[index].parent;
+		}
+		else
+		{
+			index = static_cast<int32_t>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+
+		auto& result = m_nodes[index];
+		result.user_data = nullptr;
+		result.parent = null_node;
+		result.child1 = null_node;
+		result.child2 = null_node;
+		result.height = 0;
+
+		return index;
+	}
+
+	void aabb_tree::free_node(int32_t index)
+	{
+		m_nodes[index].parent = m_free_list;
+		m_nodes[index].height = -1;
+		m_free_list = index;
+	}
+
+	void aabb_tree::insert_leaf(int32_t leaf)
+	{
+		if (m_root == null_node)
+		{
+			m_root = leaf;
+			m_nodes[leaf].parent = null_node;
+			return;
+		}
+
+		//Walks down to the sibling which increases the summed perimeter of the tree the least
+		box leaf_bounds = m_nodes[leaf].bounds;
+		int32_t index = m_root;
+
+		while (!m_nodes[index].is_leaf())
+		{
+			const auto& current = m_nodes[index];
+
+			float perimeter = get_perimeter(current.bounds);
+			float combined_perimeter = get_perimeter(combine(current.bounds, leaf_bounds));
+
+			//Cost of a new parent for this node and the leaf, and the cost pushed down to the children
+			float cost = 2.0f * combined_perimeter;
+			float inheritance_cost = 2.0f * (combined_perimeter - perimeter);
+
+			auto descend_cost = [&](int32_t child)
+			{
+				const auto& child_node = m_nodes[child];
+				float combined = get_perimeter(combine(leaf_bounds, child_node.bounds));
+
+				if (child_node.is_leaf())
+					return combined + inheritance_cost;
+
+				return combined - get_perimeter(child_node.bounds) + inheritance_cost;
+			};
+
+			float cost1 = descend_cost(current.child1);
+			float cost2 = descend_cost(current.child2);
+
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = cost1 < cost2 ? current.child1 : current.child2;
+		}
+
+		int32_t sibling = index;
+		int32_t old_parent = m_nodes[sibling].parent;
+		int32_t new_parent = allocate_node();
+
+		m_nodes[new_parent].parent = old_parent;
+		m_nodes[new_parent].bounds = combine(leaf_bounds, m_nodes[sibling].bounds);
+		m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+		m_nodes[new_parent].child1 = sibling;
+		m_nodes[new_parent].child2 = leaf;
+		m_nodes[sibling].parent = new_parent;
+		m_nodes[leaf].parent = new_parent;
+
+		if (old_parent != null_node)
+		{
+			if (m_nodes[old_parent].child1 == sibling)
+				m_nodes[old_parent].child1 = new_parent;
+			else
+				m_nodes[old_parent].child2 = new_parent;
+		}
+		else
+		{
+			m_root = new_parent;
+		}
+
+		refit_ancestors(m_nodes[leaf].parent);
+	}
+
+	void aabb_tree::remove_leaf(int32_t leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = null_node;
+			return;
+		}
+
+		int32_t parent = m_nodes[leaf].parent;
+		int32_t grand_parent = m_nodes[parent].parent;
+		int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+		free_node(parent);
+
+		if (grand_parent == null_node)
+		{
+			m_root = sibling;
+			m_nodes[sibling].parent = null_node;
+			return;
+		}
+
+		if (m_nodes[grand_parent].child1 == parent)
+			m_nodes[grand_parent].child1 = sibling;
+		else
+			m_nodes[grand_parent].child2 = sibling;
+
+		m_nodes[sibling].parent = grand_parent;
+
+		refit_ancestors(grand_parent);
+	}
+
+	void aabb_tree::refit_ancestors(int32_t index)
+	{
+		while (index != null_node)
+		{
+			index = balance(index);
+
+			auto& current = m_nodes[index];
+			const auto& child1 = m_nodes[current.child1];
+			const auto& child2 = m_nodes[current.child2];
+
+			current.height = 1 + std::max(child1.height, child2.height);
+			current.bounds = combine(child1.bounds, child2.bounds);
+
+			index = current.parent;
+		}
+	}
+
+	//Rotates the higher child up, if the heights of the children differ by more than one
+	int32_t aabb_tree::balance(int32_t index_a)
+	{
+		auto& a = m_nodes[index_a];
+		if (a.is_leaf() || a.height < 2)
+			return index_a;
+
+		int32_t index_b = a.child1;
+		int32_t index_c = a.child2;
+		auto& b = m_nodes[index_b];
+		auto& c = m_nodes[index_c];
+
+		int32_t difference = c.height - b.height;
+
+		auto replace_in_parent = [this](int32_t parent, int32_t old_child, int32_t new_child)
+		{
+			if (parent == null_node)
+			{
+				m_root = new_child;
+				return;
+			}
+
+			if (m_nodes[parent].child1 == old_child)
+				m_nodes[parent].child1 = new_child;
+			else
+				m_nodes[parent].child2 = new_child;
+		};
+
+		if (difference > 1)
+		{
+			int32_t index_f = c.child1;
+			int32_t index_g = c.child2;
+			auto& f = m_nodes[index_f];
+			auto& g = m_nodes[index_g];
+
+			c.child1 = index_a;
+			c.parent = a.parent;
+			a.parent = index_c;
+			replace_in_parent(c.parent, index_a, index_c);
+
+			if (f.height > g.height)
+			{
+				c.child2 = index_f;
+				a.child2 = index_g;
+				g.parent = index_a;
+				a.bounds = combine(b.bounds, g.bounds);
+				c.bounds = combine(a.bounds, f.bounds);
+				a.height = 1 + std::max(b.height, g.height);
+				c.height = 1 + std::max(a.height, f.height);
+			}
+			else
+			{
+				c.child2 = index_g;
+				a.child2 = index_f;
+				f.parent = index_a;
+				a.bounds = combine(b.bounds, f.bounds);
+				c.bounds = combine(a.bounds, g.bounds);
+				a.height = 1 + std::max(b.height, f.height);
+				c.height = 1 + std::max(a.height, g.height);
+			}
+
+			return index_c;
+		}
+
+		if (difference < -1)
+		{
+			int32_t index_d = b.child1;
+			int32_t index_e = b.child2;
+			auto& d = m_nodes[index_d];
+			auto& e = m_nodes[index_e];
+
+			b.child1 = index_a;
+			b.parent = a.parent;
+			a.parent = index_b;
+			replace_in_parent(b.parent, index_a, index_b);
+
+			if (d.height > e.height)
+			{
+				b.child2 = index_d;
+				a.child1 = index_e;
+				e.parent = index_a;
+				a.bounds = combine(c.bounds, e.bounds);
+				b.bounds = combine(a.bounds, d.bounds);
+				a.height = 1 + std::max(c.height, e.height);
+				b.height = 1 + std::max(a.height, d.height);
+			}
+			else
+			{
+				b.child2 = index_e;
+				a.child1 = index_d;
+				d.parent = index_a;
+				a.bounds = combine(c.bounds, d.bounds);
+				b.bounds = combine(a.bounds, e.bounds);
+				a.height = 1 + std::max(c.height, d.height);
+				b.height = 1 + std::max(a.height, e.height);
+			}
+
+			return index_b;
+		}
+
+		return index_a;
+	}
+
+	//Splits the leaves at the median of their centers along the longer axis
+	int32_t aabb_tree::build(int32_t* first, int32_t* last)
+	{
+		if (last - first == 1)
+			return *first;
+
+		box center_bounds{ glm::vec2{ std::numeric_limits<float>::max() }, glm::vec2{ std::numeric_limits<float>::lowest() } };
+		for (auto* it = first; it != last; ++it)
+		{
+			const auto& bounds = m_nodes[*it].bounds;
+			glm::vec2 center = (bounds.min + bounds.max) * 0.5f;
+			center_bounds.min = glm::min(center_bounds.min, center);
+			center_bounds.max = glm::max(center_bounds.max, center);
+		}
+
+		glm::vec2 extent = center_bounds.max - center_bounds.min;
+		int axis = extent.x >= extent.y ? 0 : 1;
+
+		auto* middle = first + (last - first) / 2;
+		std::nth_element(first, middle, last, [this, axis](int32_t lhs, int32_t rhs)
+		{
+			const auto& a = m_nodes[lhs].bounds;
+			const auto& b = m_nodes[rhs].bounds;
+
+			return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis];
+		});
+
+		int32_t child1 = build(first, middle);
+		int32_t child2 = build(middle, last);
+
+		int32_t index = allocate_node();
+		auto& parent = m_nodes[index];
+		parent.child1 = child1;
+		parent.child2 = child2;
+		parent.bounds = combine(m_nodes[child1].bounds, m_nodes[child2].bounds);
+		parent.height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+
+		m_nodes[child1].parent = index;
+		m_nodes[child2].parent = index;
+
+		return index;
+	}
+}
@@ -3,6 +3,7 @@
 #include <stdexcept>
 
 #include "graphics/render_states.h"
+#include "graphics/vertex_kernels.h"
 
 static constexpr float PI = 3.141592654f;
 
@@ -108,19 +109,46 @@ namespace age
 		return m_outline_color;
 	}
 
+	void circle_shape::set_retained(bool value)
+	{
+		if (m_retained == value)
+			return;
+
+		m_retained = value;
+
+		if (!m_retained)
+		{
+			m_mesh.reset();
+			m_outline_mesh.reset();
+		}
+	}
+
+	bool circle_shape::is_retained() const
+	{
+		return m_retained;
+	}
+
 	void circle_shape::draw(render_target& target, const render_states& states) const
 	{
 		render_states states_copy = states;
 
 		states_copy.get_transform() *= get_transform();
 		states_copy.set_texture(*m_texture);
+		states_copy.set_batching(true);
 
-		target.draw(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size(), states_copy);
+		if (m_retained)
+			target.draw(m_mesh.update(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size()), states_copy);
+		else
+			target.draw(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size(), states_copy);
 
 		if (m_outline_thickness != 0.0f)
 		{
 			states_copy.set_texture(engine::get_instance()->get_default_texture());
-			target.draw(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size(), states_copy);
+
+			if (m_retained)
+				target.draw(m_outline_mesh.update(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size()), states_copy);
+			else
+				target.draw(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size(), states_copy);
 		}
 	}
 
@@ -129,6 +157,15 @@ namespace age
 		return shape_2d::vertex_data{ m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size() };
 	}
 
+	shape_2d::vertex_data circle_shape::on_get_outline_vertex_data() const
+	{
+		//The outline vertices are only kept up to date while there is an outline
+		if (m_outline_thickness == 0.0f)
+			return shape_2d::vertex_data{ nullptr, 0, nullptr, 0 };
+
+		return shape_2d::vertex_data{ m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size() };
+	}
+
 	void circle_shape::gen_vertices()
 	{
 		m_vertices.clear();
@@ -151,6 +188,8 @@ namespace age
 		}
 
 		m_indices.back() = 1;
+
+		m_mesh.invalidate();
 	}
 
 	void circle_shape::gen_outline_vertices()
@@ -186,16 +225,20 @@ namespace age
 		m_outline_indices[last_index - 4] = 0;
 		m_outline_indices[last_index - 3] = 0;
 		m_outline_indices[last_index - 2] = 1;
+
+		m_outline_mesh.invalidate();
 	}
 
 	void circle_shape::update_fill_color()
 	{
-		for (auto& v : m_vertices) v.color = m_fill_color;
+		set_colors(m_vertices.data(), m_vertices.size(), m_fill_color);
+		m_mesh.invalidate();
 	}
 
 	void circle_shape::update_outline_color()
 	{
-		for (auto& v : m_outline_vertices) v.color = m_outline_color;
+		set_colors(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_color);
+		m_outline_mesh.invalidate();
 	}
 
 	void circle_shape::scale_for_outline()
@@ -209,5 +252,7 @@ namespace age
 			auto index = i + 1;
 			m_vertices[index].position = glm::vec2{ cos(angle) * inner_radius + m_radius, sin(angle) * inner_radius + m_radius };
 		}
+
+		m_mesh.invalidate();
 	}
 }
\ No newline at end of file
@@ -21,6 +21,8 @@ namespace age
                     throw std::runtime_error{ std::string{ "Failed to make context current\nSDL3 Error: " } + SDL_GetError() };
                 }
             }
+
+            gl_state::set_current(&m_gl_state);
             return;
         }
 
@@ -30,9 +32,16 @@ namespace age
             {
                 throw std::runtime_error{ std::string{ "Failed to make context current\nSDL3 Error: " } + SDL_GetError() };
             }
+
+            gl_state::set_current(nullptr);
         }
     }
 
+    gl_state& context::get_gl_state()
+    {
+        return m_gl_state;
+    }
+
     bool context::is_active() const
     {
         return SDL_GL_GetCurrentContext() == m_GL_context.get();
@@ -78,22 +87,25 @@ namespace age
             SDL_GL_MakeCurrent(internal_window_handle, static_cast<SDL_GLContext>(m_GL_context.get()));
         }
 
+        // Whatever the previous user of the context left behind is unknown, so the mirror starts from scratch
+        m_gl_state.invalidate();
+
         // Unbind textures
-        glBindTexture(GL_TEXTURE_2D, 0);
+        m_gl_state.bind_texture(0, GL_TEXTURE_2D, 0);
 
         // Unbind shader program
-        glUseProgram(0);
+        m_gl_state.use_program(0);
 
         // Unbind VAO
-        glBindVertexArray(0);
+        m_gl_state.bind_vertex_array(0);
 
         // Unbind framebuffer
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        m_gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
 
         // Unbind buffer objects
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        m_gl_state.bind_buffer(GL_ARRAY_BUFFER, 0);
+        m_gl_state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        m_gl_state.bind_buffer(GL_UNIFORM_BUFFER, 0);
 
         if (current_context != m_GL_context.get())
         {
@@ -142,6 +154,8 @@ namespace age
             {
                 throw std::runtime_error{ std::string{ "Failed to make context current\nSDL Error: " } + SDL_GetError() };
             }
+
+            gl_state::set_current(&m_gl_state);
         }
     }
 
@@ -165,6 +179,31 @@ namespace age
             }
         }
 
+        return create_shared_context();
+    }
+
+    void context::prewarm_shared_contexts(size_t count)
+    {
+        std::lock_guard<std::mutex> lock{ m_acquire_context_mutex };
+
+        if (!m_GL_shared_context)
+        {
+            throw std::runtime_error{ std::string{ "Prewarming shared contexts from a shared context is not possible. Prewarm from main context!" }};
+        }
+
+        size_t num_unused = 0;
+        for (auto& v : m_shared_context_list)
+        {
+            if (v.use_count() == 1)
+                ++num_unused;
+        }
+
+        for (; num_unused < count; ++num_unused)
+            create_shared_context();
+    }
+
+    std::shared_ptr<context> context::create_shared_context()
+    {
         auto current_context = SDL_GL_GetCurrentContext();
 
         //For testing in WayLand
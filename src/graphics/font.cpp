@@ -653,24 +653,16 @@ namespace age
 
 			if (texture_needs_resizing)
 			{
-				texture new_texture;
+				// The glyphs are copied on the GPU, so growing the page doesn't stall
 				try
 				{
-					new_texture.create(texture_size);
+					page.texture.resize(texture_size, true);
 				}
 				catch (const std::exception& e)
 				{
 					std::cout << "Failed to create new page texture: " << e.what() << std::endl;
 					return result;
 				}
-
-				new_texture.set_smooth(m_smooth);
-				new_texture.update(page.texture);
-				/*
-				* Move assigment should do actually
-				page.texture.swap(newTexture);
-				*/
-				page.texture = std::move(new_texture);
 			}
 
 			// We can now create the new row
@@ -0,0 +1,405 @@
+#include "graphics/gl_state.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+#include "utility/gl_check.h"
+
+namespace age
+{
+	gl_state::gl_state()
+	{
+		invalidate();
+	}
+
+	gl_state& gl_state::get_current()
+	{
+		//Code which runs before a context registered its state, uses a state of its own per thread
+		static thread_local gl_state fallback;
+
+		return m_current ? *m_current : fallback;
+	}
+
+	void gl_state::set_current(gl_state* value)
+	{
+		m_current = value;
+
+		//Without a registered context nothing is known about the state
+		if (!value)
+			get_current().invalidate();
+	}
+
+	void gl_state::invalidate()
+	{
+		m_program = unknown;
+		m_vertex_array = unknown;
+		m_buffers.fill(unknown);
+		m_uniform_bindings.fill(buffer_range{});
+		m_shader_storage_bindings.fill(buffer_range{});
+
+		m_active_texture_unit = unknown;
+		for (auto& unit : m_textures)
+			unit.fill(unknown);
+
+		m_draw_framebuffer = unknown;
+		m_read_framebuffer = unknown;
+
+		m_blend_func.fill(unknown);
+		m_blend_equation.fill(unknown);
+
+		m_viewport_known = false;
+		m_scissor_known = false;
+
+		m_capabilities.clear();
+	}
+
+	bool gl_state::use_program(uint32_t program)
+	{
+		if (m_program == program)
+			return false;
+
+		GL_CALL(glUseProgram(program));
+		m_program = program;
+
+		return true;
+	}
+
+	bool gl_state::bind_vertex_array(uint32_t vertex_array)
+	{
+		if (m_vertex_array == vertex_array)
+			return false;
+
+		GL_CALL(glBindVertexArray(vertex_array));
+		m_vertex_array = vertex_array;
+
+		//The element array binding is part of the vertex array
+		m_buffers[static_cast<uint32_t>(buffer_slot::element_array)] = unknown;
+
+		return true;
+	}
+
+	bool gl_state::bind_buffer(uint32_t gl_target, uint32_t buffer)
+	{
+		auto slot = get_buffer_slot(gl_target);
+
+		if (slot >= 0 && m_buffers[slot] == buffer)
+			return false;
+
+		GL_CALL(glBindBuffer(gl_target, buffer));
+
+		if (slot >= 0)
+			m_buffers[slot] = buffer;
+
+		return true;
+	}
+
+	bool gl_state::bind_buffer_base(uint32_t gl_target, uint32_t index, uint32_t buffer)
+	{
+		auto bindings = get_indexed_bindings(gl_target);
+
+		if (bindings && index < max_indexed_buffer_bindings)
+		{
+			auto& binding = (*bindings)[index];
+			if (binding.buffer == buffer && binding.offset == 0 && binding.size == 0)
+				return false;
+		}
+
+		GL_CALL(glBindBufferBase(gl_target, index, buffer));
+
+		if (bindings && index < max_indexed_buffer_bindings)
+			(*bindings)[index] = buffer_range{ buffer, 0, 0 };
+
+		//Binding an index also binds the generic binding point
+		auto slot = get_buffer_slot(gl_target);
+		if (slot >= 0)
+			m_buffers[slot] = buffer;
+
+		return true;
+	}
+
+	bool gl_state::bind_buffer_range(uint32_t gl_target, uint32_t index, uint32_t buffer, size_t offset, size_t size)
+	{
+		if (is_buffer_range_bound(gl_target, index, buffer, offset, size))
+			return false;
+
+		GL_CALL(glBindBufferRange(gl_target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size)));
+
+		auto bindings = get_indexed_bindings(gl_target);
+		if (bindings && index < max_indexed_buffer_bindings)
+			(*bindings)[index] = buffer_range{ buffer, offset, size };
+
+		auto slot = get_buffer_slot(gl_target);
+		if (slot >= 0)
+			m_buffers[slot] = buffer;
+
+		return true;
+	}
+
+	bool gl_state::is_buffer_range_bound(uint32_t gl_target, uint32_t index, uint32_t buffer, size_t offset, size_t size) const
+	{
+		auto bindings = get_indexed_bindings(gl_target);
+
+		if (!bindings || index >= max_indexed_buffer_bindings)
+			return false;
+
+		auto& binding = (*bindings)[index];
+		return binding.buffer == buffer && binding.offset == offset && binding.size == size;
+	}
+
+	bool gl_state::active_texture(uint32_t unit)
+	{
+		if (m_active_texture_unit == unit)
+			return false;
+
+		GL_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+		m_active_texture_unit = unit;
+
+		return true;
+	}
+
+	bool gl_state::bind_texture(uint32_t gl_target, uint32_t texture)
+	{
+		//Without a known unit the binding can not be mirrored
+		if (m_active_texture_unit == unknown)
+			active_texture(0);
+
+		return bind_texture(m_active_texture_unit, gl_target, texture);
+	}
+
+	bool gl_state::bind_texture(uint32_t unit, uint32_t gl_target, uint32_t texture)
+	{
+		auto slot = get_texture_slot(gl_target);
+		bool mirrored = slot >= 0 && unit < max_texture_units;
+
+		if (mirrored && m_textures[unit][slot] == texture)
+			return false;
+
+		active_texture(unit);
+		GL_CALL(glBindTexture(gl_target, texture));
+
+		if (mirrored)
+			m_textures[unit][slot] = texture;
+
+		return true;
+	}
+
+	bool gl_state::bind_framebuffer(uint32_t gl_target, uint32_t framebuffer)
+	{
+		switch (gl_target)
+		{
+			case GL_DRAW_FRAMEBUFFER:
+				if (m_draw_framebuffer == framebuffer)
+					return false;
+
+				m_draw_framebuffer = framebuffer;
+				break;
+			case GL_READ_FRAMEBUFFER:
+				if (m_read_framebuffer == framebuffer)
+					return false;
+
+				m_read_framebuffer = framebuffer;
+				break;
+			default:
+				if (m_draw_framebuffer == framebuffer && m_read_framebuffer == framebuffer)
+					return false;
+
+				m_draw_framebuffer = framebuffer;
+				m_read_framebuffer = framebuffer;
+				break;
+		}
+
+		GL_CALL(glBindFramebuffer(gl_target, framebuffer));
+
+		return true;
+	}
+
+	bool gl_state::set_blend_func(uint32_t src_color, uint32_t dst_color, uint32_t src_alpha, uint32_t dst_alpha)
+	{
+		std::array<uint32_t, 4> value{ src_color, dst_color, src_alpha, dst_alpha };
+
+		if (m_blend_func == value)
+			return false;
+
+		GL_CALL(glBlendFuncSeparate(src_color, dst_color, src_alpha, dst_alpha));
+		m_blend_func = value;
+
+		return true;
+	}
+
+	bool gl_state::set_blend_equation(uint32_t color, uint32_t alpha)
+	{
+		std::array<uint32_t, 2> value{ color, alpha };
+
+		if (m_blend_equation == value)
+			return false;
+
+		GL_CALL(glBlendEquationSeparate(color, alpha));
+		m_blend_equation = value;
+
+		return true;
+	}
+
+	bool gl_state::set_viewport(int32_t x, int32_t y, int32_t width, int32_t height)
+	{
+		std::array<int32_t, 4> value{ x, y, width, height };
+
+		if (m_viewport_known && m_viewport == value)
+			return false;
+
+		GL_CALL(glViewport(x, y, width, height));
+		m_viewport = value;
+		m_viewport_known = true;
+
+		return true;
+	}
+
+	bool gl_state::set_scissor(int32_t x, int32_t y, int32_t width, int32_t height)
+	{
+		std::array<int32_t, 4> value{ x, y, width, height };
+
+		if (m_scissor_known && m_scissor == value)
+			return false;
+
+		GL_CALL(glScissor(x, y, width, height));
+		m_scissor = value;
+		m_scissor_known = true;
+
+		return true;
+	}
+
+	bool gl_state::set_enabled(uint32_t capability, bool value)
+	{
+		auto it = std::find_if(m_capabilities.begin(), m_capabilities.end(),
+			[capability](const capability_state& state) { return state.capability == capability; });
+
+		if (it != m_capabilities.end() && it->enabled == value)
+			return false;
+
+		if (value)
+			GL_CALL(glEnable(capability));
+		else
+			GL_CALL(glDisable(capability));
+
+		if (it != m_capabilities.end())
+			it->enabled = value;
+		else
+			m_capabilities.push_back(capability_state{ capability, value });
+
+		return true;
+	}
+
+	void gl_state::forget_program(uint32_t program)
+	{
+		if (m_program == program)
+			m_program = unknown;
+	}
+
+	void gl_state::forget_vertex_array(uint32_t vertex_array)
+	{
+		if (m_vertex_array == vertex_array)
+		{
+			m_vertex_array = unknown;
+			m_buffers[static_cast<uint32_t>(buffer_slot::element_array)] = unknown;
+		}
+	}
+
+	void gl_state::forget_buffer(uint32_t buffer)
+	{
+		for (auto& bound : m_buffers)
+		{
+			if (bound == buffer)
+				bound = unknown;
+		}
+
+		for (auto bindings : { &m_uniform_bindings, &m_shader_storage_bindings })
+		{
+			for (auto& binding : *bindings)
+			{
+				if (binding.buffer == buffer)
+					binding = buffer_range{};
+			}
+		}
+	}
+
+	void gl_state::forget_texture(uint32_t texture)
+	{
+		for (auto& unit : m_textures)
+		{
+			for (auto& bound : unit)
+			{
+				if (bound == texture)
+					bound = unknown;
+			}
+		}
+	}
+
+	void gl_state::forget_framebuffer(uint32_t framebuffer)
+	{
+		if (m_draw_framebuffer == framebuffer)
+			m_draw_framebuffer = unknown;
+
+		if (m_read_framebuffer == framebuffer)
+			m_read_framebuffer = unknown;
+	}
+
+	int32_t gl_state::get_buffer_slot(uint32_t gl_target)
+	{
+		switch (gl_target)
+		{
+			case GL_ARRAY_BUFFER:
+				return static_cast<int32_t>(buffer_slot::array);
+			case GL_ELEMENT_ARRAY_BUFFER:
+				return static_cast<int32_t>(buffer_slot::element_array);
+			case GL_UNIFORM_BUFFER:
+				return static_cast<int32_t>(buffer_slot::uniform);
+			case GL_SHADER_STORAGE_BUFFER:
+				return static_cast<int32_t>(buffer_slot::shader_storage);
+			case GL_DRAW_INDIRECT_BUFFER:
+				return static_cast<int32_t>(buffer_slot::draw_indirect);
+			case GL_PIXEL_PACK_BUFFER:
+				return static_cast<int32_t>(buffer_slot::pixel_pack);
+			case GL_PIXEL_UNPACK_BUFFER:
+				return static_cast<int32_t>(buffer_slot::pixel_unpack);
+			case GL_COPY_READ_BUFFER:
+				return static_cast<int32_t>(buffer_slot::copy_read);
+			case GL_COPY_WRITE_BUFFER:
+				return static_cast<int32_t>(buffer_slot::copy_write);
+			default:
+				return -1;
+		}
+	}
+
+	int32_t gl_state::get_texture_slot(uint32_t gl_target)
+	{
+		switch (gl_target)
+		{
+			case GL_TEXTURE_2D:
+				return static_cast<int32_t>(texture_slot::texture_2d);
+			case GL_TEXTURE_2D_MULTISAMPLE:
+				return static_cast<int32_t>(texture_slot::texture_2d_multisample);
+			case GL_TEXTURE_2D_ARRAY:
+				return static_cast<int32_t>(texture_slot::texture_2d_array);
+			default:
+				return -1;
+		}
+	}
+
+	gl_state::indexed_bindings* gl_state::get_indexed_bindings(uint32_t gl_target)
+	{
+		return const_cast<indexed_bindings*>(static_cast<const gl_state*>(this)->get_indexed_bindings(gl_target));
+	}
+
+	const gl_state::indexed_bindings* gl_state::get_indexed_bindings(uint32_t gl_target) const
+	{
+		switch (gl_target)
+		{
+			case GL_UNIFORM_BUFFER:
+				return &m_uniform_bindings;
+			case GL_SHADER_STORAGE_BUFFER:
+				return &m_shader_storage_bindings;
+			default:
+				return nullptr;
+		}
+	}
+}
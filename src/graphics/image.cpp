@@ -6,12 +6,21 @@
 #include <stb_image_write.h>
 
 #include <iterator>
+#include <cstring>
 #include <stdexcept>
 #include <sstream>
 #include <memory>
 #include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <fstream>
 
 #include "system/assetstream.h"
+#include "system/mapped_file.h"
+#include "graphics/raw_texture.h"
+#include "graphics/image_kernels.h"
 #include "utility/utility.h"
 
 namespace
@@ -47,7 +56,7 @@ namespace
 	{
 		auto* source = static_cast<std::uint8_t*>(data);
 		auto* dest = static_cast<std::vector<std::uint8_t>*>(context);
-		std::copy(source, source + size, std::back_inserter(*dest));
+		dest->insert(dest->end(), source, source + size);
 	}
 
 	void load_image_from_stream(std::istream& stream, std::vector<uint8_t>& pixels, glm::u32vec2& size)
@@ -140,6 +149,28 @@ namespace
 			throw std::runtime_error{ ss.str() };
 		}
 	}
+
+	std::vector<std::byte> read_file(const std::string& fn)
+	{
+		age::assetistream is{ fn.data(), std::ios::binary };
+		if (!is)
+			throw std::runtime_error{ "Failed to open image file " + fn };
+
+		is.seekg(0, std::ios::end);
+		auto size = is.tellg();
+		is.seekg(0, std::ios::beg);
+
+		if (size <= 0)
+			throw std::runtime_error{ "Failed to read image file " + fn };
+
+		std::vector<std::byte> data(static_cast<std::size_t>(size));
+		is.read(reinterpret_cast<char*>(data.data()), size);
+
+		if (is.gcount() != size)
+			throw std::runtime_error{ "Failed to read image file " + fn };
+
+		return data;
+	}
 } // namespace
 
 
@@ -153,15 +184,7 @@ namespace age
 			std::vector<std::uint8_t> newPixels(static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y) * 4);
 
 			// Fill it with the specified color
-			std::uint8_t* ptr = newPixels.data();
-			std::uint8_t* end = ptr + newPixels.size();
-			while (ptr < end)
-			{
-				*ptr++ = the_color.r;
-				*ptr++ = the_color.g;
-				*ptr++ = the_color.b;
-				*ptr++ = the_color.a;
-			}
+			fill_pixels(newPixels.data(), newPixels.size() / 4, the_color);
 
 			// Commit the new pixel buffer
 			m_pixels.swap(newPixels);
@@ -224,6 +247,133 @@ namespace age
 		load_image_from_stream(is, m_pixels, m_size);
 	}
 
+	void image::load_many(const std::vector<std::string>& paths, const load_callback& callback, size_t thread_count, size_t max_in_flight)
+	{
+		if (paths.empty())
+			return;
+
+		if (thread_count == 0)
+			thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+		if (max_in_flight == 0)
+			max_in_flight = thread_count * 2;
+
+		//Threads beyond the in flight limit would never get any work
+		thread_count = std::min({ thread_count, max_in_flight, paths.size() });
+
+		std::mutex mutex;
+		std::condition_variable slot_freed;
+		std::condition_variable result_ready;
+
+		std::vector<std::optional<image_load_result>> results(paths.size());
+		size_t next_index = 0;
+		size_t num_consumed = 0;
+		bool abort = false;
+
+		auto decode = [&]()
+		{
+			while (true)
+			{
+				size_t index;
+
+				{
+					//Files are handed out in order, so everything between num_consumed and next_index is in flight
+					std::unique_lock lock{ mutex };
+					slot_freed.wait(lock, [&]() -> bool { return abort || next_index == paths.size() || next_index - num_consumed < max_in_flight; });
+
+					if (abort || next_index == paths.size())
+						return;
+
+					index = next_index++;
+				}
+
+				image_load_result result;
+
+				try
+				{
+					//Decoding from memory is a lot faster than through the stream callbacks
+					auto data = read_file(paths[index]);
+					result.img.load(data.data(), data.size());
+				}
+				catch (...)
+				{
+					result.error = std::current_exception();
+				}
+
+				{
+					std::lock_guard lock{ mutex };
+					results[index] = std::move(result);
+				}
+
+				result_ready.notify_all();
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count);
+
+		auto stop = [&]()
+		{
+			{
+				std::lock_guard lock{ mutex };
+				abort = true;
+			}
+
+			slot_freed.notify_all();
+
+			for (auto& thread : threads)
+				thread.join();
+		};
+
+		try
+		{
+			for (size_t i = 0; i < thread_count; ++i)
+				threads.emplace_back(decode);
+
+			for (size_t index = 0; index < paths.size(); ++index)
+			{
+				image_load_result result;
+
+				{
+					std::unique_lock lock{ mutex };
+					result_ready.wait(lock, [&]() -> bool { return results[index].has_value(); });
+
+					result = std::move(*results[index]);
+					results[index].reset();
+					++num_consumed;
+				}
+
+				slot_freed.notify_all();
+				callback(index, result);
+			}
+		}
+		catch (...)
+		{
+			stop();
+			throw;
+		}
+
+		stop();
+	}
+
+	std::vector<image_load_result> image::load_many(const std::vector<std::string>& paths, size_t thread_count)
+	{
+		std::vector<image_load_result> results(paths.size());
+
+		//All results are kept anyway, so there is no point in limiting the images in flight
+		load_many(paths, [&results](size_t index, image_load_result& result) { results[index] = std::move(result); }, thread_count, paths.size());
+
+		return results;
+	}
+
+	void image::load_raw(std::string_view fn)
+	{
+		mapped_file file{ fn };
+		auto levels = raw_texture::parse(file.get_data(), file.get_size());
+
+		create(levels.front().size, levels.front().pixels);
+	}
+
 	void image::save(const std::string_view& value)
 	{
 		auto errfunc = [&value]() {
@@ -278,7 +428,54 @@ namespace age
 
 	void image::save(std::vector<uint8_t>& data, const std::string_view& format)
 	{
+		auto errfunc = [&format]() {
+			std::stringstream ss;
+
+			ss << "Error saving image to memory. " << format;
+			throw std::runtime_error{ ss.str() };
+		};
+
+		data.clear();
+
+		auto extension = format;
+		if (!extension.empty() && extension.front() == '.')
+			extension.remove_prefix(1);
+
+		int width = static_cast<int>(m_size.x);
+		int height = static_cast<int>(m_size.y);
+		int written = 0;
+
+		if (extension == "bmp")
+			written = stbi_write_bmp_to_func(&buffer_from_callback, &data, width, height, 4, m_pixels.data());
+		else if (extension == "tga")
+			written = stbi_write_tga_to_func(&buffer_from_callback, &data, width, height, 4, m_pixels.data());
+		else if (extension == "png")
+			written = stbi_write_png_to_func(&buffer_from_callback, &data, width, height, 4, m_pixels.data(), 0);
+		else if (extension == "jpg" || extension == "jpeg")
+			written = stbi_write_jpg_to_func(&buffer_from_callback, &data, width, height, 4, m_pixels.data(), 90);
+
+		if (!written)
+			errfunc();
+	}
+
+	std::future<std::vector<uint8_t>> image::save_async(image img, std::string_view format)
+	{
+		return std::async(std::launch::async, [img = std::move(img), format = std::string{ format }]() mutable
+		{
+			std::vector<uint8_t> result;
+			img.save(result, format);
 
+			return result;
+		});
+	}
+
+	void image::save_raw(std::string_view fn, bool generate_mipmaps) const
+	{
+		std::ofstream os{ std::string{ fn }, std::ios::binary };
+		if (!os)
+			throw std::runtime_error{ "Error saving image. " + std::string{ fn } };
+
+		raw_texture::write(os, m_size, m_pixels.data(), generate_mipmaps);
 	}
 
 	void image::create_mask_from_color(const color& color_key, uint8_t alpha)
@@ -287,14 +484,36 @@ namespace age
 		if (!m_pixels.empty())
 		{
 			// Replace the alpha of the pixels that match the transparent color
-			std::uint8_t* ptr = m_pixels.data();
-			std::uint8_t* end = ptr + m_pixels.size();
-			while (ptr < end)
-			{
-				if ((ptr[0] == color_key.r) && (ptr[1] == color_key.g) && (ptr[2] == color_key.b) && (ptr[3] == color_key.a))
-					ptr[3] = alpha;
-				ptr += 4;
-			}
+			mask_pixels(m_pixels.data(), m_pixels.size() / 4, color_key, alpha);
+		}
+	}
+
+	void image::copy(const image& source, const glm::u32vec2& dest, const uint_rect& source_rect)
+	{
+		uint_rect area = source_rect;
+		if (area.width == 0 || area.height == 0)
+			area = uint_rect{ glm::u32vec2{ 0, 0 }, source.m_size };
+
+		// Clip the area to the source, then to the destination
+		if (area.left >= source.m_size.x || area.top >= source.m_size.y || dest.x >= m_size.x || dest.y >= m_size.y)
+			return;
+
+		uint32_t width = std::min({ area.width, source.m_size.x - area.left, m_size.x - dest.x });
+		uint32_t height = std::min({ area.height, source.m_size.y - area.top, m_size.y - dest.y });
+
+		std::size_t row_bytes = static_cast<std::size_t>(width) * 4;
+
+		// An image copied onto itself is copied bottom up when the rows move down, so no row is overwritten before it is read
+		bool bottom_up = &source == this && dest.y > area.top;
+
+		for (uint32_t i = 0; i < height; ++i)
+		{
+			uint32_t y = bottom_up ? height - 1 - i : i;
+
+			const std::uint8_t* from = &source.m_pixels[(static_cast<std::size_t>(area.top + y) * source.m_size.x + area.left) * 4];
+			std::uint8_t* to = &m_pixels[(static_cast<std::size_t>(dest.y + y) * m_size.x + dest.x) * 4];
+
+			std::memmove(to, from, row_bytes);
 		}
 	}
 
@@ -330,19 +549,7 @@ namespace age
 			std::size_t rowSize = m_size.x * 4;
 
 			for (std::size_t y = 0; y < m_size.y; ++y)
-			{
-				auto left = m_pixels.begin() + static_cast<std::vector<std::uint8_t>::iterator::difference_type>(y * rowSize);
-				auto right = m_pixels.begin() +
-					static_cast<std::vector<std::uint8_t>::iterator::difference_type>((y + 1) * rowSize - 4);
-
-				for (std::size_t x = 0; x < m_size.x / 2; ++x)
-				{
-					std::swap_ranges(left, left + 4, right);
-
-					left += 4;
-					right -= 4;
-				}
-			}
+				reverse_pixels(m_pixels.data() + y * rowSize, m_size.x);
 		}
 	}
 
@@ -350,14 +557,14 @@ namespace age
 	{
 		if (!m_pixels.empty())
 		{
-			auto rowSize = static_cast<std::vector<std::uint8_t>::iterator::difference_type>(m_size.x * 4);
+			std::size_t rowSize = m_size.x * 4;
 
-			auto top = m_pixels.begin();
-			auto bottom = m_pixels.end() - rowSize;
+			std::uint8_t* top = m_pixels.data();
+			std::uint8_t* bottom = m_pixels.data() + m_pixels.size() - rowSize;
 
 			for (std::size_t y = 0; y < m_size.y / 2; ++y)
 			{
-				std::swap_ranges(top, top + rowSize, bottom);
+				swap_pixels(top, bottom, m_size.x);
 
 				top += rowSize;
 				bottom -= rowSize;
@@ -365,6 +572,21 @@ namespace age
 		}
 	}
 
+	void image::premultiply_alpha()
+	{
+		premultiply_pixels(m_pixels.data(), m_pixels.size() / 4);
+	}
+
+	void image::unpremultiply_alpha()
+	{
+		unpremultiply_pixels(m_pixels.data(), m_pixels.size() / 4);
+	}
+
+	void image::swap_red_blue()
+	{
+		swap_red_blue_pixels(m_pixels.data(), m_pixels.size() / 4);
+	}
+
 	std::istream& operator >> (std::istream& in, image& im)
 	{
 		im.load(in);
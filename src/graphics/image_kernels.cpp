@@ -0,0 +1,552 @@
+#include "graphics/image_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "utility/cpu_features.h"
+
+namespace age
+{
+	namespace
+	{
+		static_assert(sizeof(color) == 4, "color needs to have the layout of one RGBA8 pixel");
+
+		//Colors are passed as the 4 bytes of a pixel, so comparing and storing them doesn't depend on the byte order
+		struct image_kernels
+		{
+			void (*fill)(uint8_t*, size_t, uint32_t);
+			void (*mask)(uint8_t*, size_t, uint32_t, uint8_t);
+			void (*reverse)(uint8_t*, size_t);
+			void (*swap)(uint8_t*, uint8_t*, size_t);
+			void (*premultiply)(uint8_t*, size_t);
+			void (*unpremultiply)(uint8_t*, size_t);
+			void (*swap_red_blue)(uint8_t*, size_t);
+			const char* isa;
+		};
+
+		inline uint32_t to_pixel(const color& value)
+		{
+			uint32_t result;
+			std::memcpy(&result, &value, sizeof(result));
+
+			return result;
+		}
+
+		inline uint8_t modulate(uint8_t value, uint8_t factor)
+		{
+			//Exact rounded division by 255, which the SIMD code does the same way
+			uint32_t x = static_cast<uint32_t>(value) * factor + 128;
+			return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+		}
+
+		inline uint8_t unmodulate(uint8_t value, uint8_t alpha)
+		{
+			//Done in single precision like the SIMD code, which has no integer division
+			float result = static_cast<float>(value * 255) / static_cast<float>(alpha) + 0.5f;
+			return static_cast<uint8_t>(std::min(result, 255.0f));
+		}
+
+		void fill_scalar(uint8_t* pixels, size_t count, uint32_t value)
+		{
+			for (size_t i = 0; i < count; ++i)
+				std::memcpy(pixels + 4 * i, &value, 4);
+		}
+
+		void mask_scalar(uint8_t* pixels, size_t count, uint32_t key, uint8_t alpha)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (std::memcmp(pixels + 4 * i, &key, 4) == 0)
+					pixels[4 * i + 3] = alpha;
+			}
+		}
+
+		void reverse_scalar(uint8_t* pixels, size_t count)
+		{
+			for (size_t i = 0, j = count; i + 1 < j; ++i, --j)
+			{
+				uint32_t left;
+				uint32_t right;
+				std::memcpy(&left, pixels + 4 * i, 4);
+				std::memcpy(&right, pixels + 4 * (j - 1), 4);
+				std::memcpy(pixels + 4 * i, &right, 4);
+				std::memcpy(pixels + 4 * (j - 1), &left, 4);
+			}
+		}
+
+		void swap_scalar(uint8_t* first, uint8_t* second, size_t count)
+		{
+			std::swap_ranges(first, first + 4 * count, second);
+		}
+
+		void premultiply_scalar(uint8_t* pixels, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint8_t* pixel = pixels + 4 * i;
+				for (size_t c = 0; c < 3; ++c)
+					pixel[c] = modulate(pixel[c], pixel[3]);
+			}
+		}
+
+		void unpremultiply_scalar(uint8_t* pixels, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint8_t* pixel = pixels + 4 * i;
+				if (pixel[3] == 0 || pixel[3] == 255)
+					continue;
+
+				for (size_t c = 0; c < 3; ++c)
+					pixel[c] = unmodulate(pixel[c], pixel[3]);
+			}
+		}
+
+		void swap_red_blue_scalar(uint8_t* pixels, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				std::swap(pixels[4 * i], pixels[4 * i + 2]);
+		}
+
+#ifdef AGE_SIMD_X86
+		//x86 is little endian, so the alpha is the most significant byte of a pixel loaded as 32 bit value
+		inline __m128i load(const uint8_t* pixels)
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+		}
+
+		inline void store(uint8_t* pixels, __m128i value)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), value);
+		}
+
+		void fill_sse2(uint8_t* pixels, size_t count, uint32_t value)
+		{
+			const __m128i v = _mm_set1_epi32(static_cast<int32_t>(value));
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+				store(pixels + 4 * i, v);
+
+			fill_scalar(pixels + 4 * i, count - i, value);
+		}
+
+		void mask_sse2(uint8_t* pixels, size_t count, uint32_t key, uint8_t alpha)
+		{
+			const __m128i keys = _mm_set1_epi32(static_cast<int32_t>(key));
+			const __m128i alpha_mask = _mm_set1_epi32(static_cast<int32_t>(0xff000000u));
+			const __m128i alphas = _mm_set1_epi32(static_cast<int32_t>(uint32_t{ alpha } << 24));
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i v = load(pixels + 4 * i);
+				__m128i equal = _mm_cmpeq_epi32(v, keys);
+
+				v = _mm_or_si128(_mm_andnot_si128(_mm_and_si128(equal, alpha_mask), v), _mm_and_si128(equal, alphas));
+				store(pixels + 4 * i, v);
+			}
+
+			mask_scalar(pixels + 4 * i, count - i, key, alpha);
+		}
+
+		void reverse_sse2(uint8_t* pixels, size_t count)
+		{
+			//Blocks of 4 pixels from both ends are reversed and exchanged until they would overlap
+			size_t i = 0;
+			size_t j = count;
+			for (; j - i >= 8; i += 4, j -= 4)
+			{
+				__m128i left = load(pixels + 4 * i);
+				__m128i right = load(pixels + 4 * (j - 4));
+
+				store(pixels + 4 * i, _mm_shuffle_epi32(right, _MM_SHUFFLE(0, 1, 2, 3)));
+				store(pixels + 4 * (j - 4), _mm_shuffle_epi32(left, _MM_SHUFFLE(0, 1, 2, 3)));
+			}
+
+			reverse_scalar(pixels + 4 * i, j - i);
+		}
+
+		void swap_sse2(uint8_t* first, uint8_t* second, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i a = load(first + 4 * i);
+				__m128i b = load(second + 4 * i);
+
+				store(first + 4 * i, b);
+				store(second + 4 * i, a);
+			}
+
+			swap_scalar(first + 4 * i, second + 4 * i, count - i);
+		}
+
+		//Two pixels in 16 bit lanes, multiplied by their alpha with the rounding of modulate
+		inline __m128i premultiply_half(__m128i x)
+		{
+			//The alpha lanes are multiplied by 255, which keeps them
+			const __m128i alpha_lanes = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+
+			__m128i factor = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			factor = _mm_or_si128(_mm_andnot_si128(alpha_lanes, factor), _mm_and_si128(alpha_lanes, _mm_set1_epi16(255)));
+
+			x = _mm_add_epi16(_mm_mullo_epi16(x, factor), _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+		}
+
+		void premultiply_sse2(uint8_t* pixels, size_t count)
+		{
+			const __m128i zero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i v = load(pixels + 4 * i);
+				__m128i low = premultiply_half(_mm_unpacklo_epi8(v, zero));
+				__m128i high = premultiply_half(_mm_unpackhi_epi8(v, zero));
+
+				store(pixels + 4 * i, _mm_packus_epi16(low, high));
+			}
+
+			premultiply_scalar(pixels + 4 * i, count - i);
+		}
+
+		//One pixel in 32 bit lanes
+		inline __m128i unpremultiply_pixel(__m128i pixel)
+		{
+			__m128 value = _mm_cvtepi32_ps(pixel);
+			__m128 alpha = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3));
+
+			__m128 result = _mm_add_ps(_mm_div_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), alpha), _mm_set1_ps(0.5f));
+			result = _mm_min_ps(result, _mm_set1_ps(255.0f));
+
+			//The alpha itself and pixels with an alpha of 0 or 255 keep their values
+			__m128 keep = _mm_or_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), _mm_cmpeq_ps(alpha, _mm_set1_ps(255.0f)));
+			keep = _mm_or_ps(keep, _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1)));
+			result = _mm_or_ps(_mm_and_ps(keep, value), _mm_andnot_ps(keep, result));
+
+			return _mm_cvttps_epi32(result);
+		}
+
+		void unpremultiply_sse2(uint8_t* pixels, size_t count)
+		{
+			const __m128i zero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i v = load(pixels + 4 * i);
+				__m128i low = _mm_unpacklo_epi8(v, zero);
+				__m128i high = _mm_unpackhi_epi8(v, zero);
+
+				__m128i p0 = unpremultiply_pixel(_mm_unpacklo_epi16(low, zero));
+				__m128i p1 = unpremultiply_pixel(_mm_unpackhi_epi16(low, zero));
+				__m128i p2 = unpremultiply_pixel(_mm_unpacklo_epi16(high, zero));
+				__m128i p3 = unpremultiply_pixel(_mm_unpackhi_epi16(high, zero));
+
+				store(pixels + 4 * i, _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3)));
+			}
+
+			unpremultiply_scalar(pixels + 4 * i, count - i);
+		}
+
+		void swap_red_blue_sse2(uint8_t* pixels, size_t count)
+		{
+			const __m128i green_alpha = _mm_set1_epi32(static_cast<int32_t>(0xff00ff00u));
+			const __m128i low_byte = _mm_set1_epi32(0xff);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i v = load(pixels + 4 * i);
+				__m128i red = _mm_slli_epi32(_mm_and_si128(v, low_byte), 16);
+				__m128i blue = _mm_and_si128(_mm_srli_epi32(v, 16), low_byte);
+
+				store(pixels + 4 * i, _mm_or_si128(_mm_and_si128(v, green_alpha), _mm_or_si128(red, blue)));
+			}
+
+			swap_red_blue_scalar(pixels + 4 * i, count - i);
+		}
+
+		AGE_TARGET_AVX2 inline __m256i load_avx2(const uint8_t* pixels)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+		}
+
+		AGE_TARGET_AVX2 inline void store_avx2(uint8_t* pixels, __m256i value)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), value);
+		}
+
+		AGE_TARGET_AVX2 void fill_avx2(uint8_t* pixels, size_t count, uint32_t value)
+		{
+			const __m256i v = _mm256_set1_epi32(static_cast<int32_t>(value));
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+				store_avx2(pixels + 4 * i, v);
+
+			fill_sse2(pixels + 4 * i, count - i, value);
+		}
+
+		AGE_TARGET_AVX2 void mask_avx2(uint8_t* pixels, size_t count, uint32_t key, uint8_t alpha)
+		{
+			const __m256i keys = _mm256_set1_epi32(static_cast<int32_t>(key));
+			const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int32_t>(0xff000000u));
+			const __m256i alphas = _mm256_set1_epi32(static_cast<int32_t>(uint32_t{ alpha } << 24));
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i v = load_avx2(pixels + 4 * i);
+				__m256i equal = _mm256_cmpeq_epi32(v, keys);
+
+				v = _mm256_or_si256(_mm256_andnot_si256(_mm256_and_si256(equal, alpha_mask), v), _mm256_and_si256(equal, alphas));
+				store_avx2(pixels + 4 * i, v);
+			}
+
+			mask_sse2(pixels + 4 * i, count - i, key, alpha);
+		}
+
+		AGE_TARGET_AVX2 void reverse_avx2(uint8_t* pixels, size_t count)
+		{
+			const __m256i reversed = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+			size_t i = 0;
+			size_t j = count;
+			for (; j - i >= 16; i += 8, j -= 8)
+			{
+				__m256i left = load_avx2(pixels + 4 * i);
+				__m256i right = load_avx2(pixels + 4 * (j - 8));
+
+				store_avx2(pixels + 4 * i, _mm256_permutevar8x32_epi32(right, reversed));
+				store_avx2(pixels + 4 * (j - 8), _mm256_permutevar8x32_epi32(left, reversed));
+			}
+
+			reverse_sse2(pixels + 4 * i, j - i);
+		}
+
+		AGE_TARGET_AVX2 inline __m256i premultiply_half_avx2(__m256i x)
+		{
+			const __m256i alpha_lanes = _mm256_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+
+			__m256i factor = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			factor = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, factor), _mm256_and_si256(alpha_lanes, _mm256_set1_epi16(255)));
+
+			x = _mm256_add_epi16(_mm256_mullo_epi16(x, factor), _mm256_set1_epi16(128));
+			return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+		}
+
+		AGE_TARGET_AVX2 void premultiply_avx2(uint8_t* pixels, size_t count)
+		{
+			const __m256i zero = _mm256_setzero_si256();
+
+			//Unpacking and packing both work within 128 bit lanes, so the pixels end up where they came from
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i v = load_avx2(pixels + 4 * i);
+				__m256i low = premultiply_half_avx2(_mm256_unpacklo_epi8(v, zero));
+				__m256i high = premultiply_half_avx2(_mm256_unpackhi_epi8(v, zero));
+
+				store_avx2(pixels + 4 * i, _mm256_packus_epi16(low, high));
+			}
+
+			premultiply_sse2(pixels + 4 * i, count - i);
+		}
+
+		AGE_TARGET_AVX2 void swap_red_blue_avx2(uint8_t* pixels, size_t count)
+		{
+			const __m256i order = _mm256_setr_epi8(
+				2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+				2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+				store_avx2(pixels + 4 * i, _mm256_shuffle_epi8(load_avx2(pixels + 4 * i), order));
+
+			swap_red_blue_sse2(pixels + 4 * i, count - i);
+		}
+#endif
+
+#ifdef AGE_SIMD_NEON
+		//vld4q_u8 splits 16 pixels into their channels, which doesn't depend on the byte order
+		void fill_neon(uint8_t* pixels, size_t count, uint32_t value)
+		{
+			uint8_t channels[4];
+			std::memcpy(channels, &value, 4);
+
+			uint8x16x4_t v;
+			for (size_t c = 0; c < 4; ++c)
+				v.val[c] = vdupq_n_u8(channels[c]);
+
+			size_t i = 0;
+			for (; i + 16 <= count; i += 16)
+				vst4q_u8(pixels + 4 * i, v);
+
+			fill_scalar(pixels + 4 * i, count - i, value);
+		}
+
+		void mask_neon(uint8_t* pixels, size_t count, uint32_t key, uint8_t alpha)
+		{
+			uint8_t channels[4];
+			std::memcpy(channels, &key, 4);
+
+			const uint8x16_t alphas = vdupq_n_u8(alpha);
+
+			size_t i = 0;
+			for (; i + 16 <= count; i += 16)
+			{
+				uint8x16x4_t v = vld4q_u8(pixels + 4 * i);
+
+				uint8x16_t equal = vceqq_u8(v.val[0], vdupq_n_u8(channels[0]));
+				for (size_t c = 1; c < 4; ++c)
+					equal = vandq_u8(equal, vceqq_u8(v.val[c], vdupq_n_u8(channels[c])));
+
+				v.val[3] = vbslq_u8(equal, alphas, v.val[3]);
+				vst4q_u8(pixels + 4 * i, v);
+			}
+
+			mask_scalar(pixels + 4 * i, count - i, key, alpha);
+		}
+
+		inline uint32x4_t reverse4(uint32x4_t v)
+		{
+			uint32x4_t swapped = vrev64q_u32(v);
+			return vcombine_u32(vget_high_u32(swapped), vget_low_u32(swapped));
+		}
+
+		void reverse_neon(uint8_t* pixels, size_t count)
+		{
+			size_t i = 0;
+			size_t j = count;
+			for (; j - i >= 8; i += 4, j -= 4)
+			{
+				uint32x4_t left = vreinterpretq_u32_u8(vld1q_u8(pixels + 4 * i));
+				uint32x4_t right = vreinterpretq_u32_u8(vld1q_u8(pixels + 4 * (j - 4)));
+
+				vst1q_u8(pixels + 4 * i, vreinterpretq_u8_u32(reverse4(right)));
+				vst1q_u8(pixels + 4 * (j - 4), vreinterpretq_u8_u32(reverse4(left)));
+			}
+
+			reverse_scalar(pixels + 4 * i, j - i);
+		}
+
+		void swap_neon(uint8_t* first, uint8_t* second, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				uint8x16_t a = vld1q_u8(first + 4 * i);
+				uint8x16_t b = vld1q_u8(second + 4 * i);
+
+				vst1q_u8(first + 4 * i, b);
+				vst1q_u8(second + 4 * i, a);
+			}
+
+			swap_scalar(first + 4 * i, second + 4 * i, count - i);
+		}
+
+		inline uint8x8_t modulate_neon(uint8x8_t value, uint8x8_t factor)
+		{
+			uint16x8_t x = vaddq_u16(vmull_u8(value, factor), vdupq_n_u16(128));
+			return vshrn_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+		}
+
+		void premultiply_neon(uint8_t* pixels, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 16 <= count; i += 16)
+			{
+				uint8x16x4_t v = vld4q_u8(pixels + 4 * i);
+
+				for (size_t c = 0; c < 3; ++c)
+				{
+					v.val[c] = vcombine_u8(
+						modulate_neon(vget_low_u8(v.val[c]), vget_low_u8(v.val[3])),
+						modulate_neon(vget_high_u8(v.val[c]), vget_high_u8(v.val[3])));
+				}
+
+				vst4q_u8(pixels + 4 * i, v);
+			}
+
+			premultiply_scalar(pixels + 4 * i, count - i);
+		}
+
+		void swap_red_blue_neon(uint8_t* pixels, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 16 <= count; i += 16)
+			{
+				uint8x16x4_t v = vld4q_u8(pixels + 4 * i);
+				std::swap(v.val[0], v.val[2]);
+				vst4q_u8(pixels + 4 * i, v);
+			}
+
+			swap_red_blue_scalar(pixels + 4 * i, count - i);
+		}
+#endif
+
+		image_kernels select_kernels()
+		{
+#if defined(AGE_SIMD_X86)
+			if (cpu_features::has_avx2())
+				return image_kernels{ fill_avx2, mask_avx2, reverse_avx2, swap_sse2, premultiply_avx2, unpremultiply_sse2, swap_red_blue_avx2, "avx2" };
+
+			return image_kernels{ fill_sse2, mask_sse2, reverse_sse2, swap_sse2, premultiply_sse2, unpremultiply_sse2, swap_red_blue_sse2, "sse2" };
+#elif defined(AGE_SIMD_NEON)
+			//Unpremultiplying needs a division, which 32 bit ARM has no vector instruction for
+			return image_kernels{ fill_neon, mask_neon, reverse_neon, swap_neon, premultiply_neon, unpremultiply_scalar, swap_red_blue_neon, "neon" };
+#else
+			return image_kernels{ fill_scalar, mask_scalar, reverse_scalar, swap_scalar, premultiply_scalar, unpremultiply_scalar, swap_red_blue_scalar, "scalar" };
+#endif
+		}
+
+		const image_kernels& get_kernels()
+		{
+			static const image_kernels kernels = select_kernels();
+			return kernels;
+		}
+	}
+
+	void fill_pixels(uint8_t pixels[], size_t count, const color& value)
+	{
+		get_kernels().fill(pixels, count, to_pixel(value));
+	}
+
+	void mask_pixels(uint8_t pixels[], size_t count, const color& key, uint8_t alpha)
+	{
+		get_kernels().mask(pixels, count, to_pixel(key), alpha);
+	}
+
+	void reverse_pixels(uint8_t pixels[], size_t count)
+	{
+		get_kernels().reverse(pixels, count);
+	}
+
+	void swap_pixels(uint8_t first[], uint8_t second[], size_t count)
+	{
+		get_kernels().swap(first, second, count);
+	}
+
+	void premultiply_pixels(uint8_t pixels[], size_t count)
+	{
+		get_kernels().premultiply(pixels, count);
+	}
+
+	void unpremultiply_pixels(uint8_t pixels[], size_t count)
+	{
+		get_kernels().unpremultiply(pixels, count);
+	}
+
+	void swap_red_blue_pixels(uint8_t pixels[], size_t count)
+	{
+		get_kernels().swap_red_blue(pixels, count);
+	}
+
+	const char* get_image_kernels_isa()
+	{
+		return get_kernels().isa;
+	}
+}
@@ -0,0 +1,170 @@
+#include "graphics/instanced_sprite_batch.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <array>
+
+#include "graphics/render_target.h"
+#include "graphics/render_states.h"
+#include "engine.h"
+#include "utility/gl_check.h"
+
+namespace age
+{
+	instanced_sprite_batch::instanced_sprite_batch()
+		: m_texture{ &engine::get_instance()->get_default_texture() }
+	{
+		init_mesh();
+	}
+
+	instanced_sprite_batch::instanced_sprite_batch(const texture& texture)
+		: m_texture{ &texture }
+	{
+		init_mesh();
+	}
+
+	void instanced_sprite_batch::set_texture(const texture& value)
+	{
+		m_texture = &value;
+	}
+
+	const texture& instanced_sprite_batch::get_texture() const
+	{
+		return *m_texture;
+	}
+
+	size_t instanced_sprite_batch::add(const sprite_instance& instance)
+	{
+		m_instances.push_back(instance);
+		apply_default_texture_rect(m_instances.back());
+
+		m_needs_update = true;
+
+		return m_instances.size() - 1;
+	}
+
+	void instanced_sprite_batch::set(size_t index, const sprite_instance& instance)
+	{
+		m_instances[index] = instance;
+		apply_default_texture_rect(m_instances[index]);
+
+		m_needs_update = true;
+	}
+
+	const sprite_instance& instanced_sprite_batch::get(size_t index) const
+	{
+		return m_instances[index];
+	}
+
+	void instanced_sprite_batch::set_instances(const sprite_instance instances[], size_t num_instances)
+	{
+		m_instances.assign(instances, instances + num_instances);
+
+		for (auto& instance : m_instances)
+			apply_default_texture_rect(instance);
+
+		m_needs_update = true;
+	}
+
+	void instanced_sprite_batch::resize(size_t num_instances)
+	{
+		sprite_instance instance{ {}, {}, { 1.0f, 1.0f }, 0.0f, color::white, {} };
+		apply_default_texture_rect(instance);
+
+		m_instances.resize(num_instances, instance);
+		m_needs_update = true;
+	}
+
+	void instanced_sprite_batch::clear()
+	{
+		m_instances.clear();
+		m_needs_update = true;
+	}
+
+	size_t instanced_sprite_batch::get_size() const
+	{
+		return m_instances.size();
+	}
+
+	void instanced_sprite_batch::draw(render_target& target, const render_states& states) const
+	{
+		if (m_instances.empty())
+			return;
+
+		if (m_needs_update)
+		{
+			//Orphans the previous storage so the upload doesn't stall on draws which still read from it
+			m_instance_buffer_object.buffer_data(m_instances.data(), m_instances.size() * sizeof(sprite_instance), vertex_buffer_object::usage::stream_draw);
+			m_needs_update = false;
+		}
+
+		render_states states_copy = states;
+		states_copy.set_texture(*m_texture);
+
+		auto* e = engine::get_instance();
+		if (&states_copy.get_shader_program() == &e->get_default_shader_program())
+			states_copy.set_shader_program(e->get_instanced_shader_program());
+
+		target.draw_instanced(m_mesh, m_instances.size(), states_copy);
+	}
+
+	void instanced_sprite_batch::init_mesh()
+	{
+		//Unit quad which is scaled to the size of the texture rect of each instance in the vertex shader
+		std::array<vertex_2d, 4> vertices =
+		{
+			vertex_2d{ { 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			vertex_2d{ { 1.0f, 0.0f }, { 1.0f, 0.0f } },
+			vertex_2d{ { 1.0f, 1.0f }, { 1.0f, 1.0f } },
+			vertex_2d{ { 0.0f, 1.0f }, { 0.0f, 1.0f } }
+		};
+
+		std::array<uint32_t, 6> indices = { 0, 1, 2, 0, 2, 3 };
+
+		m_mesh.upload(vertices.data(), vertices.size(), indices.data(), indices.size());
+
+		//The instance attributes are part of the vertex array object state of the quad, so they only need to be set up once
+		m_mesh.get_vertex_array_object().bind();
+		m_instance_buffer_object.bind();
+
+		auto stride = static_cast<GLsizei>(sizeof(sprite_instance));
+
+		GL_CALL(glEnableVertexAttribArray(engine::get_i_position_index()));
+		GL_CALL(glVertexAttribPointer(engine::get_i_position_index(), 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(sprite_instance, position))));
+		GL_CALL(glVertexAttribDivisor(engine::get_i_position_index(), 1));
+
+		GL_CALL(glEnableVertexAttribArray(engine::get_i_origin_index()));
+		GL_CALL(glVertexAttribPointer(engine::get_i_origin_index(), 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(sprite_instance, origin))));
+		GL_CALL(glVertexAttribDivisor(engine::get_i_origin_index(), 1));
+
+		GL_CALL(glEnableVertexAttribArray(engine::get_i_scale_index()));
+		GL_CALL(glVertexAttribPointer(engine::get_i_scale_index(), 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(sprite_instance, scale))));
+		GL_CALL(glVertexAttribDivisor(engine::get_i_scale_index(), 1));
+
+		GL_CALL(glEnableVertexAttribArray(engine::get_i_rotation_index()));
+		GL_CALL(glVertexAttribPointer(engine::get_i_rotation_index(), 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(sprite_instance, rotation))));
+		GL_CALL(glVertexAttribDivisor(engine::get_i_rotation_index(), 1));
+
+		GL_CALL(glEnableVertexAttribArray(engine::get_i_color_index()));
+		GL_CALL(glVertexAttribPointer(engine::get_i_color_index(), 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<void*>(offsetof(sprite_instance, color))));
+		GL_CALL(glVertexAttribDivisor(engine::get_i_color_index(), 1));
+
+		GL_CALL(glEnableVertexAttribArray(engine::get_i_texture_rect_index()));
+		GL_CALL(glVertexAttribPointer(engine::get_i_texture_rect_index(), 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(sprite_instance, texture_rect))));
+		GL_CALL(glVertexAttribDivisor(engine::get_i_texture_rect_index(), 1));
+	}
+
+	float_rect instanced_sprite_batch::get_full_texture_rect() const
+	{
+		auto& tex_size = m_texture->get_size();
+
+		return float_rect{ { 0.0f, 0.0f }, { static_cast<float>(tex_size.x), static_cast<float>(tex_size.y) } };
+	}
+
+	void instanced_sprite_batch::apply_default_texture_rect(sprite_instance& instance) const
+	{
+		if (instance.texture_rect.width == 0.0f || instance.texture_rect.height == 0.0f)
+			instance.texture_rect = get_full_texture_rect();
+	}
+}
@@ -0,0 +1,88 @@
+#include "graphics/mesh_2d.h"
+
+#include "engine.h"
+
+namespace age
+{
+	mesh_2d::mesh_2d()
+	{}
+
+	void mesh_2d::upload(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices)
+	{
+		upload_vertices(vertices, num_vertices);
+
+		m_element_buffer_object.buffer_data(indices, num_indices * sizeof(uint32_t), vertex_buffer_object::usage::static_draw);
+
+		m_num_indices = num_indices;
+		m_primitive_type = primitive_type::triangles;
+	}
+
+	void mesh_2d::upload(const vertex_2d vertices[], size_t num_vertices, primitive_type type)
+	{
+		upload_vertices(vertices, num_vertices);
+
+		m_num_indices = 0;
+		m_primitive_type = type;
+	}
+
+	void mesh_2d::bind() const
+	{
+		m_vertex_array_object.bind();
+	}
+
+	void mesh_2d::upload_vertices(const vertex_2d vertices[], size_t num_vertices)
+	{
+		//The element buffer binding is part of the vertex array object state, so it has to be bound first
+		m_vertex_array_object.bind();
+
+		m_vertex_buffer_object.buffer_data(vertices, num_vertices * sizeof(vertex_2d), vertex_buffer_object::usage::static_draw);
+		engine::set_vertex_2d_attributes();
+
+		m_num_vertices = num_vertices;
+	}
+
+	retained_mesh::retained_mesh(const retained_mesh& /*other*/)
+		: m_needs_update{ true }
+	{}
+
+	retained_mesh& retained_mesh::operator = (const retained_mesh& /*other*/)
+	{
+		m_needs_update = true;
+
+		return *this;
+	}
+
+	void retained_mesh::reset()
+	{
+		m_mesh.reset();
+		m_needs_update = true;
+	}
+
+	const mesh_2d& retained_mesh::update(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices)
+	{
+		if (!m_mesh)
+			m_mesh = std::make_unique<mesh_2d>();
+
+		if (m_needs_update)
+		{
+			m_mesh->upload(vertices, num_vertices, indices, num_indices);
+			m_needs_update = false;
+		}
+
+		return *m_mesh;
+	}
+
+	const mesh_2d& retained_mesh::update(const vertex_2d vertices[], size_t num_vertices, primitive_type type)
+	{
+		if (!m_mesh)
+			m_mesh = std::make_unique<mesh_2d>();
+
+		if (m_needs_update)
+		{
+			m_mesh->upload(vertices, num_vertices, type);
+			m_needs_update = false;
+		}
+
+		return *m_mesh;
+	}
+}
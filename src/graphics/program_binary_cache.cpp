@@ -0,0 +1,212 @@
+#include "graphics/program_binary_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "utility/gl_check.h"
+
+namespace age
+{
+	namespace
+	{
+		constexpr std::array<char, 4> magic{ 'A', 'G', 'P', 'B' };
+		constexpr uint32_t version = 1;
+
+		//Written in the byte order of the machine, the cache is never shared between machines anyway
+		struct file_header
+		{
+			std::array<char, 4> magic;
+			uint32_t version;
+			uint32_t binary_format;
+			uint32_t reserved;
+			//Second hash of the key, guards against collisions of the file name
+			uint64_t check;
+			uint64_t binary_size;
+		};
+
+		uint64_t hash_key(std::string_view key, uint64_t seed)
+		{
+			//FNV-1a
+			uint64_t hash = 14695981039346656037ull ^ seed;
+			for (char c : key)
+			{
+				hash ^= static_cast<uint8_t>(c);
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		uint64_t get_check(std::string_view key)
+		{
+			return hash_key(key, 0x9e3779b97f4a7c15ull);
+		}
+
+		bool is_binary_format_supported(GLenum format)
+		{
+			GLint num_formats = 0;
+			GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats));
+
+			if (num_formats <= 0)
+				return false;
+
+			std::vector<GLint> formats(static_cast<size_t>(num_formats));
+			GL_CALL(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data()));
+
+			return std::find(formats.begin(), formats.end(), static_cast<GLint>(format)) != formats.end();
+		}
+
+		std::string_view get_gl_string(GLenum name)
+		{
+			auto value = reinterpret_cast<const char*>(GL_CALL(glGetString(name)));
+			return value ? std::string_view{ value } : std::string_view{};
+		}
+	}
+
+	std::string program_binary_cache::m_directory;
+
+	void program_binary_cache::set_directory(std::string_view directory)
+	{
+		m_directory = directory;
+	}
+
+	const std::string& program_binary_cache::get_directory()
+	{
+		return m_directory;
+	}
+
+	bool program_binary_cache::is_enabled()
+	{
+		return !m_directory.empty();
+	}
+
+	bool program_binary_cache::load(uint32_t program, std::string_view description)
+	{
+		if (!is_enabled())
+			return false;
+
+		std::string key = get_key(description);
+		std::string path = get_path(key);
+
+		std::ifstream is{ path, std::ios::binary };
+		if (!is)
+			return false;
+
+		file_header header;
+		is.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		std::vector<char> binary;
+		bool valid = is && header.magic == magic && header.version == version && header.check == get_check(key) && header.binary_size > 0;
+
+		if (valid)
+		{
+			binary.resize(static_cast<size_t>(header.binary_size));
+			is.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+			valid = is.gcount() == static_cast<std::streamsize>(binary.size()) && is_binary_format_supported(header.binary_format);
+		}
+
+		is.close();
+
+		if (valid)
+		{
+			GL_CALL(glProgramBinary(program, header.binary_format, binary.data(), static_cast<GLsizei>(binary.size())));
+
+			GLint success = GL_FALSE;
+			GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &success));
+
+			valid = success == GL_TRUE;
+		}
+
+		//The driver rejected the entry, so it is replaced by the next store
+		if (!valid)
+		{
+			std::error_code error;
+			std::filesystem::remove(path, error);
+		}
+
+		return valid;
+	}
+
+	void program_binary_cache::store(uint32_t program, std::string_view description)
+	{
+		if (!is_enabled())
+			return;
+
+		GLint binary_size = 0;
+		GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_size));
+
+		if (binary_size <= 0)
+			return;
+
+		std::vector<char> binary(static_cast<size_t>(binary_size));
+		GLenum binary_format = 0;
+		GLsizei length = 0;
+		GL_CALL(glGetProgramBinary(program, binary_size, &length, &binary_format, binary.data()));
+
+		if (length <= 0)
+			return;
+
+		std::string key = get_key(description);
+		std::string path = get_path(key);
+
+		std::error_code error;
+		std::filesystem::create_directories(m_directory, error);
+
+		file_header header{ magic, version, binary_format, 0, get_check(key), static_cast<uint64_t>(length) };
+
+		//Written to a temporary file first, so another process never loads a partially written entry
+		std::string temporary_path = path + ".tmp";
+
+		{
+			std::ofstream os{ temporary_path, std::ios::binary | std::ios::trunc };
+			os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			os.write(binary.data(), length);
+
+			if (!os)
+			{
+				os.close();
+				std::filesystem::remove(temporary_path, error);
+
+				return;
+			}
+		}
+
+		std::filesystem::rename(temporary_path, path, error);
+		if (error)
+			std::filesystem::remove(temporary_path, error);
+	}
+
+	std::string program_binary_cache::get_key(std::string_view description)
+	{
+		std::string key{ description };
+
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			key += '\n';
+			key += get_gl_string(name);
+		}
+
+		return key;
+	}
+
+	std::string program_binary_cache::get_path(std::string_view key)
+	{
+		static constexpr char digits[] = "0123456789abcdef";
+
+		uint64_t hash = hash_key(key, 0);
+		std::string name(16, '0');
+
+		for (size_t i = 0; i < name.size(); ++i)
+			name[name.size() - 1 - i] = digits[(hash >> (4 * i)) & 0xf];
+
+		return (std::filesystem::path{ m_directory } / (name + ".bin")).string();
+	}
+}
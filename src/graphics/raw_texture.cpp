@@ -0,0 +1,180 @@
+#include "graphics/raw_texture.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace age
+{
+	namespace raw_texture
+	{
+		constexpr std::array<char, 4> magic{ 'A', 'G', 'T', 'X' };
+
+		inline uint64_t read_le(const std::byte data[], size_t num_bytes)
+		{
+			uint64_t result = 0;
+			for (size_t i = 0; i < num_bytes; ++i)
+				result |= static_cast<uint64_t>(std::to_integer<uint8_t>(data[i])) << (8 * i);
+
+			return result;
+		}
+
+		inline void write_le(std::ostream& os, uint64_t value, size_t num_bytes)
+		{
+			for (size_t i = 0; i < num_bytes; ++i)
+				os.put(static_cast<char>((value >> (8 * i)) & 0xff));
+		}
+
+		inline glm::u32vec2 get_level_size(const glm::u32vec2& size, uint32_t level)
+		{
+			return glm::u32vec2{ std::max(size.x >> level, 1u), std::max(size.y >> level, 1u) };
+		}
+
+		inline size_t get_level_bytes(const glm::u32vec2& size)
+		{
+			return static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 4;
+		}
+
+		inline size_t align_up(size_t value)
+		{
+			return (value + payload_alignment - 1) / payload_alignment * payload_alignment;
+		}
+
+		//Averages 2x2 blocks, the last row and column are repeated for odd sizes
+		std::vector<uint8_t> downsample(const glm::u32vec2& size, const uint8_t* pixels)
+		{
+			glm::u32vec2 half = get_level_size(size, 1);
+			std::vector<uint8_t> result(get_level_bytes(half));
+
+			for (uint32_t y = 0; y < half.y; ++y)
+			{
+				uint32_t y0 = std::min(2 * y, size.y - 1);
+				uint32_t y1 = std::min(2 * y + 1, size.y - 1);
+
+				for (uint32_t x = 0; x < half.x; ++x)
+				{
+					uint32_t x0 = std::min(2 * x, size.x - 1);
+					uint32_t x1 = std::min(2 * x + 1, size.x - 1);
+
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						uint32_t sum = pixels[(y0 * size.x + x0) * 4 + c]
+							+ pixels[(y0 * size.x + x1) * 4 + c]
+							+ pixels[(y1 * size.x + x0) * 4 + c]
+							+ pixels[(y1 * size.x + x1) * 4 + c];
+
+						result[(y * half.x + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+
+			return result;
+		}
+
+		std::vector<level> parse(const std::byte data[], size_t size)
+		{
+			if (!data || size < header_size || !std::equal(magic.begin(), magic.end(), reinterpret_cast<const char*>(data)))
+				throw std::runtime_error{ "RAW_TEXTURE::PARSE NOT A RAW TEXTURE!" };
+
+			if (read_le(data + 4, 4) != version)
+				throw std::runtime_error{ "RAW_TEXTURE::PARSE UNSUPPORTED VERSION!" };
+
+			if (read_le(data + 8, 4) != format_rgba8)
+				throw std::runtime_error{ "RAW_TEXTURE::PARSE UNSUPPORTED FORMAT!" };
+
+			glm::u32vec2 texture_size{ static_cast<uint32_t>(read_le(data + 12, 4)), static_cast<uint32_t>(read_le(data + 16, 4)) };
+			if (texture_size.x == 0 || texture_size.y == 0)
+				throw std::runtime_error{ "RAW_TEXTURE::PARSE INVALID SIZE!" };
+
+			auto num_levels = static_cast<uint32_t>(read_le(data + 20, 4));
+			if (num_levels != 1 && num_levels != get_num_levels(texture_size))
+				throw std::runtime_error{ "RAW_TEXTURE::PARSE INCOMPLETE MIPMAP CHAIN!" };
+
+			if (size < header_size + num_levels * level_entry_size)
+				throw std::runtime_error{ "RAW_TEXTURE::PARSE TRUNCATED LEVEL TABLE!" };
+
+			std::vector<level> result;
+			result.reserve(num_levels);
+
+			for (uint32_t i = 0; i < num_levels; ++i)
+			{
+				const std::byte* entry = data + header_size + i * level_entry_size;
+				uint64_t offset = read_le(entry, 8);
+				uint64_t num_bytes = read_le(entry + 8, 8);
+
+				glm::u32vec2 level_size = get_level_size(texture_size, i);
+
+				if (offset % payload_alignment != 0 || num_bytes != get_level_bytes(level_size) || offset > size || num_bytes > size - offset)
+					throw std::runtime_error{ "RAW_TEXTURE::PARSE INVALID LEVEL!" };
+
+				result.push_back(level{ level_size, reinterpret_cast<const uint8_t*>(data + offset) });
+			}
+
+			return result;
+		}
+
+		void write(std::ostream& os, const glm::u32vec2& size, const uint8_t* pixels, bool generate_mipmaps)
+		{
+			if (!pixels || size.x == 0 || size.y == 0)
+				throw std::runtime_error{ "RAW_TEXTURE::WRITE EMPTY IMAGE!" };
+
+			uint32_t num_levels = generate_mipmaps ? get_num_levels(size) : 1;
+
+			//Level 0 is written straight from the pixels, only the smaller levels need memory
+			std::vector<std::vector<uint8_t>> mipmaps;
+			for (uint32_t i = 1; i < num_levels; ++i)
+			{
+				const uint8_t* source = i == 1 ? pixels : mipmaps.back().data();
+				mipmaps.push_back(downsample(get_level_size(size, i - 1), source));
+			}
+
+			os.write(magic.data(), magic.size());
+			write_le(os, version, 4);
+			write_le(os, format_rgba8, 4);
+			write_le(os, size.x, 4);
+			write_le(os, size.y, 4);
+			write_le(os, num_levels, 4);
+			write_le(os, 0, 8);
+
+			size_t offset = align_up(header_size + num_levels * level_entry_size);
+			std::vector<size_t> offsets;
+
+			for (uint32_t i = 0; i < num_levels; ++i)
+			{
+				size_t num_bytes = get_level_bytes(get_level_size(size, i));
+
+				write_le(os, offset, 8);
+				write_le(os, num_bytes, 8);
+
+				offsets.push_back(offset);
+				offset = align_up(offset + num_bytes);
+			}
+
+			size_t position = header_size + num_levels * level_entry_size;
+
+			for (uint32_t i = 0; i < num_levels; ++i)
+			{
+				for (; position < offsets[i]; ++position)
+					os.put(0);
+
+				const uint8_t* level_pixels = i == 0 ? pixels : mipmaps[i - 1].data();
+				size_t num_bytes = get_level_bytes(get_level_size(size, i));
+
+				os.write(reinterpret_cast<const char*>(level_pixels), static_cast<std::streamsize>(num_bytes));
+				position += num_bytes;
+			}
+
+			if (!os)
+				throw std::runtime_error{ "RAW_TEXTURE::WRITE FAILED TO WRITE!" };
+		}
+
+		uint32_t get_num_levels(const glm::u32vec2& size)
+		{
+			uint32_t result = 1;
+			for (uint32_t largest = std::max(size.x, size.y); largest > 1; largest >>= 1)
+				++result;
+
+			return result;
+		}
+	}
+}
@@ -0,0 +1,203 @@
+#include "graphics/readback_service.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+#include "graphics/gl_state.h"
+#include "utility/gl_check.h"
+
+namespace age
+{
+	readback_service::readback_service(size_t num_pixel_buffers)
+		: m_pixel_buffers(std::max(num_pixel_buffers, size_t{ 1 }))
+		, m_framebuffer{ create_framebuffer() }
+	{
+		for (auto& buffer : m_pixel_buffers)
+			GL_CALL(glGenBuffers(1, &buffer.id));
+	}
+
+	readback_service::~readback_service()
+	{
+		//Nobody waits for the pixels anymore, the fences just have to be deleted
+		for (auto& pending : m_pending_readbacks)
+			GL_CALL(glDeleteSync(static_cast<GLsync>(pending.fence)));
+
+		auto& state = gl_state::get_current();
+		for (auto& buffer : m_pixel_buffers)
+		{
+			state.forget_buffer(buffer.id);
+			GL_CALL(glDeleteBuffers(1, &buffer.id));
+		}
+	}
+
+	std::future<image> readback_service::read(const texture& tex)
+	{
+		if (tex.is_array())
+			throw std::runtime_error{ "READBACK_SERVICE::READ TEXTURE ARRAYS ARE NOT SUPPORTED!" };
+
+		GLint previous_read_frame_buffer;
+		GL_CALL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_frame_buffer));
+
+		auto& state = gl_state::get_current();
+		state.bind_framebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+		GL_CALL(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex.get_handle(), 0));
+
+		try
+		{
+			auto result = read_bound_framebuffer(tex.get_size(), tex.m_pixels_flipped);
+			state.bind_framebuffer(GL_READ_FRAMEBUFFER, static_cast<uint32_t>(previous_read_frame_buffer));
+
+			return result;
+		}
+		catch (...)
+		{
+			state.bind_framebuffer(GL_READ_FRAMEBUFFER, static_cast<uint32_t>(previous_read_frame_buffer));
+			throw;
+		}
+	}
+
+	std::future<image> readback_service::read(render_window& window)
+	{
+		window.activate();
+		window.flush();
+
+		GLint previous_read_frame_buffer;
+		GL_CALL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_frame_buffer));
+
+		auto& state = gl_state::get_current();
+		state.bind_framebuffer(GL_READ_FRAMEBUFFER, window.get_framebuffer_id());
+
+		try
+		{
+			auto result = read_bound_framebuffer(window.get_size(), true);
+			state.bind_framebuffer(GL_READ_FRAMEBUFFER, static_cast<uint32_t>(previous_read_frame_buffer));
+
+			return result;
+		}
+		catch (...)
+		{
+			state.bind_framebuffer(GL_READ_FRAMEBUFFER, static_cast<uint32_t>(previous_read_frame_buffer));
+			throw;
+		}
+	}
+
+	void readback_service::poll(bool wait)
+	{
+		while (!m_pending_readbacks.empty())
+		{
+			if (!wait)
+			{
+				auto fence = static_cast<GLsync>(m_pending_readbacks.front().fence);
+
+				GLenum result = GL_CALL(glClientWaitSync(fence, 0, 0));
+				if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED)
+					return;
+			}
+
+			retire_oldest_readback();
+		}
+	}
+
+	size_t readback_service::get_num_pending_readbacks() const
+	{
+		return m_pending_readbacks.size();
+	}
+
+	std::future<image> readback_service::read_bound_framebuffer(const glm::u32vec2& size, bool flip)
+	{
+		size_t num_bytes = static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 4;
+		if (num_bytes == 0)
+			throw std::runtime_error{ "READBACK_SERVICE::READ EMPTY FRAMEBUFFER!" };
+
+		//The pixel buffers are used in turn, the previous readback into the next one has to be finished before it is overwritten
+		size_t index = m_next_pixel_buffer;
+		m_next_pixel_buffer = (m_next_pixel_buffer + 1) % m_pixel_buffers.size();
+
+		auto uses_buffer = [index](const pending_readback& pending) { return pending.pixel_buffer == index; };
+		while (std::any_of(m_pending_readbacks.begin(), m_pending_readbacks.end(), uses_buffer))
+			retire_oldest_readback();
+
+		auto& state = gl_state::get_current();
+		auto& buffer = m_pixel_buffers[index];
+		state.bind_buffer(GL_PIXEL_PACK_BUFFER, buffer.id);
+
+		if (buffer.capacity < num_bytes)
+		{
+			GL_CALL(glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(num_bytes), nullptr, GL_STREAM_READ));
+			buffer.capacity = num_bytes;
+		}
+
+		//With a pixel pack buffer bound the pixel pointer is an offset into the buffer and glReadPixels returns right away
+		GL_CALL(glReadPixels(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+		state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		void* fence = GL_CALL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		//Makes sure the commands reach the GPU, the fence is never signaled otherwise
+		GL_CALL(glFlush());
+
+		pending_readback pending{ fence, std::promise<image>{}, index, size, flip };
+		auto result = pending.promise.get_future();
+
+		m_pending_readbacks.push_back(std::move(pending));
+
+		return result;
+	}
+
+	void readback_service::retire_oldest_readback()
+	{
+		auto pending = std::move(m_pending_readbacks.front());
+		m_pending_readbacks.pop_front();
+
+		auto fence = static_cast<GLsync>(pending.fence);
+
+		constexpr GLuint64 timeout_ns = 1000000000;
+		while (GL_CALL(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns)) == GL_TIMEOUT_EXPIRED);
+
+		GL_CALL(glDeleteSync(fence));
+
+		auto& state = gl_state::get_current();
+
+		try
+		{
+			size_t num_bytes = static_cast<size_t>(pending.size.x) * static_cast<size_t>(pending.size.y) * 4;
+
+			state.bind_buffer(GL_PIXEL_PACK_BUFFER, m_pixel_buffers[pending.pixel_buffer].id);
+
+			const void* source = GL_CALL(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(num_bytes), GL_MAP_READ_BIT));
+			if (!source)
+				throw std::runtime_error{ "READBACK_SERVICE::RETIRE_OLDEST_READBACK FAILED TO MAP THE PIXEL BUFFER!" };
+
+			image result;
+			result.create(pending.size, static_cast<const uint8_t*>(source));
+
+			GL_CALL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+			state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			if (pending.flip)
+				result.flip_vertical();
+
+			pending.promise.set_value(std::move(result));
+		}
+		catch (...)
+		{
+			state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+			pending.promise.set_exception(std::current_exception());
+		}
+	}
+
+	uint32_t readback_service::create_framebuffer()
+	{
+		GLuint handle;
+		GL_CALL(glGenFramebuffers(1, &handle));
+
+		return handle;
+	}
+
+	void readback_service::delete_framebuffer(uint32_t handle)
+	{
+		gl_state::get_current().forget_framebuffer(handle);
+		GL_CALL(glDeleteFramebuffers(1, &handle));
+	}
+}
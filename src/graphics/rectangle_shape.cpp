@@ -2,6 +2,7 @@
 
 #include "graphics/render_states.h"
 #include "graphics/render_target.h"
+#include "graphics/vertex_kernels.h"
 #include "engine.h"
 
 namespace age
@@ -73,6 +74,17 @@ namespace age
 		}
 	}
 
+	void rectangle_shape::set_texture_rect(const atlas_region& value)
+	{
+		if (!value.is_valid())
+			return;
+
+		m_texture = value.page;
+		m_texture_rect = value.rect;
+
+		update_tex_coords();
+	}
+
 	const uint_rect& rectangle_shape::get_texture_rect() const
 	{
 		return m_texture_rect;
@@ -93,7 +105,8 @@ namespace age
 
 	void rectangle_shape::set_fill_color(const color& value)
 	{
-		for (auto& v : m_vertices) v.color = value;
+		set_colors(m_vertices.data(), m_vertices.size(), value);
+		m_mesh.invalidate();
 	}
 
 	const color& rectangle_shape::get_fill_color() const
@@ -103,7 +116,8 @@ namespace age
 
 	void rectangle_shape::set_outline_color(const color& value)
 	{
-		for (auto& v : m_outline_vertices) v.color = value;
+		set_colors(m_outline_vertices.data(), m_outline_vertices.size(), value);
+		m_outline_mesh.invalidate();
 	}
 
 	const color& rectangle_shape::get_outline_color() const
@@ -111,6 +125,25 @@ namespace age
 		return m_outline_vertices[0].color;
 	}
 
+	void rectangle_shape::set_retained(bool value)
+	{
+		if (m_retained == value)
+			return;
+
+		m_retained = value;
+
+		if (!m_retained)
+		{
+			m_mesh.reset();
+			m_outline_mesh.reset();
+		}
+	}
+
+	bool rectangle_shape::is_retained() const
+	{
+		return m_retained;
+	}
+
 	void rectangle_shape::draw(render_target& target, const render_states& states) const
 	{
 		render_states states_copy = states;
@@ -118,13 +151,21 @@ namespace age
 		states_copy.get_transform() *= get_transform();
 		//I just assume that m_texture is initialised properly. So all other constructors shall only be called after engine has been constructed
 		states_copy.set_texture(*m_texture);
+		states_copy.set_batching(true);
 
-		target.draw(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size(), states_copy);
+		if (m_retained)
+			target.draw(m_mesh.update(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size()), states_copy);
+		else
+			target.draw(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size(), states_copy);
 
 		if (m_outline_thickness != 0.0f)
 		{
 			states_copy.set_texture(engine::get_instance()->get_default_texture());
-			target.draw(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size(), states_copy);
+
+			if (m_retained)
+				target.draw(m_outline_mesh.update(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size()), states_copy);
+			else
+				target.draw(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size(), states_copy);
 		}
 	}
 
@@ -133,6 +174,15 @@ namespace age
 		return shape_2d::vertex_data{ m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size() };
 	}
 
+	shape_2d::vertex_data rectangle_shape::on_get_outline_vertex_data() const
+	{
+		//The outline vertices are only kept up to date while there is an outline
+		if (m_outline_thickness == 0.0f)
+			return shape_2d::vertex_data{ nullptr, 0, nullptr, 0 };
+
+		return shape_2d::vertex_data{ m_outline_vertices.data(), m_outline_vertices.size(), m_outline_indices.data(), m_outline_indices.size() };
+	}
+
 	void rectangle_shape::update_vertices()
 	{
 		glm::vec2 size_without_outline{ m_size.x - 2.0f * m_outline_thickness, m_size.y - 2.0f * m_outline_thickness };
@@ -141,6 +191,8 @@ namespace age
 		m_vertices[1].position = glm::vec2{ size_without_outline.x + m_outline_thickness, m_outline_thickness };
 		m_vertices[2].position = glm::vec2{ size_without_outline.x + m_outline_thickness, size_without_outline.y + m_outline_thickness };
 		m_vertices[3].position = glm::vec2{ m_outline_thickness, size_without_outline.y + m_outline_thickness };
+
+		m_mesh.invalidate();
 	}
 
 	void rectangle_shape::update_outline()
@@ -163,6 +215,8 @@ namespace age
 
 			m_outline_vertices[6].position.x = m_vertices[3].position.x - m_outline_thickness;
 			m_outline_vertices[6].position.y = m_vertices[3].position.y + m_outline_thickness;
+
+			m_outline_mesh.invalidate();
 		}
 	}
 
@@ -174,5 +228,7 @@ namespace age
 		m_vertices[1].tex_coords = glm::vec2{ static_cast<float>(m_texture_rect.left + m_texture_rect.width), static_cast<float>(m_texture_rect.top) };
 		m_vertices[2].tex_coords = glm::vec2{ static_cast<float>(m_texture_rect.left + m_texture_rect.width), static_cast<float>(m_texture_rect.top + m_texture_rect.height) };
 		m_vertices[3].tex_coords = glm::vec2{ static_cast<float>(m_texture_rect.left), static_cast<float>(m_texture_rect.top + m_texture_rect.height) };
+
+		m_mesh.invalidate();
 	}
 }
\ No newline at end of file
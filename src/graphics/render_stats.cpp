@@ -0,0 +1,19 @@
+#include "graphics/render_stats.h"
+
+namespace age
+{
+	thread_local render_stats* render_stats::m_current = nullptr;
+
+	render_stats& render_stats::get_current()
+	{
+		//Work done while no target is active is counted here and never shown
+		static thread_local render_stats unused;
+
+		return m_current ? *m_current : unused;
+	}
+
+	void render_stats::set_current(render_stats* value)
+	{
+		m_current = value;
+	}
+}
@@ -0,0 +1,45 @@
+#include "graphics/render_stats_overlay.h"
+
+#include <sstream>
+
+#include "graphics/render_states.h"
+#include "graphics/render_target.h"
+
+namespace age
+{
+	render_stats_overlay::render_stats_overlay(const font& the_font, uint32_t the_character_size)
+		: m_text{ "", the_font, the_character_size }
+	{
+		m_text.set_outline_color(color::black);
+		m_text.set_outline_thickness(1.0f);
+	}
+
+	void render_stats_overlay::update(const render_stats& stats)
+	{
+		auto kib = [](uint64_t bytes) { return (bytes + 1023) / 1024; };
+
+		std::stringstream ss;
+		ss << "draw calls: " << stats.draw_calls << '\n'
+			<< "culled draws: " << stats.culled_draws << '\n'
+			<< "vertices: " << stats.vertices << '\n'
+			<< "indices: " << stats.indices << '\n'
+			<< "vertex upload: " << kib(stats.vertex_bytes) << " KiB\n"
+			<< "element upload: " << kib(stats.element_bytes) << " KiB\n"
+			<< "uniform upload: " << kib(stats.uniform_bytes) << " KiB\n"
+			<< "other upload: " << kib(stats.other_buffer_bytes) << " KiB\n"
+			<< "texture binds: " << stats.texture_binds << '\n'
+			<< "program binds: " << stats.program_binds << '\n'
+			<< "blend changes: " << stats.blend_changes << '\n'
+			<< "glGetError calls: " << stats.gl_error_checks;
+
+		m_text.set_string(ss.str());
+	}
+
+	void render_stats_overlay::draw(render_target& target, const render_states& states) const
+	{
+		render_states states_copy = states;
+		states_copy.get_transform() *= get_transform();
+
+		target.draw(m_text, states_copy);
+	}
+}
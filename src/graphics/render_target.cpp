@@ -1,12 +1,20 @@
 #include "graphics/render_target.h"
 
 #include <array>
+#include <algorithm>
+#include <limits>
 
 #include <glad/glad.h>
 
 #include "graphics/render_states.h"
 #include "graphics/texture.h"
+#include "graphics/shader_program.h"
+#include "graphics/mesh_2d.h"
 #include "graphics/drawable.h"
+#include "graphics/transformable_2d.h"
+#include "graphics/render_stats.h"
+#include "graphics/gl_state.h"
+#include "graphics/vertex_kernels.h"
 
 #include "utility/gl_check.h"
 
@@ -55,9 +63,74 @@ namespace age
 		return primitive_arr[static_cast<uint32_t>(value)];
 	}
 
+	constexpr inline bool is_triangle_type(primitive_type type)
+	{
+		return type == primitive_type::triangles || type == primitive_type::triangle_strip || type == primitive_type::triangle_fan;
+	}
+
+	//Every triangle primitive is turned into an indexed triangle list, so that all of them can be merged
+	inline void append_triangle_list_indices(std::vector<uint32_t>& indices, uint32_t base_index, uint32_t count, primitive_type type)
+	{
+		switch (type)
+		{
+			case primitive_type::triangle_fan:
+				for (uint32_t i = 1; i + 1 < count; ++i)
+				{
+					indices.push_back(base_index);
+					indices.push_back(base_index + i);
+					indices.push_back(base_index + i + 1);
+				}
+				break;
+
+			case primitive_type::triangle_strip:
+				for (uint32_t i = 0; i + 2 < count; ++i)
+				{
+					//Keep the winding order consistent for every second triangle
+					bool odd = i & 1;
+					indices.push_back(base_index + i + (odd ? 1 : 0));
+					indices.push_back(base_index + i + (odd ? 0 : 1));
+					indices.push_back(base_index + i + 2);
+				}
+				break;
+
+			default:
+				for (uint32_t i = 0; i + 2 < count; i += 3)
+				{
+					indices.push_back(base_index + i);
+					indices.push_back(base_index + i + 1);
+					indices.push_back(base_index + i + 2);
+				}
+				break;
+		}
+	}
+
+	//Batched and deferred geometry is drawn with an identity model matrix, so the transformation is done on the CPU
+	inline void transform_vertices(vertex_2d* first, vertex_2d* last, const glm::mat4& m)
+	{
+		if (m == glm::mat4{ 1.0f })
+			return;
+
+		transform_positions(first, static_cast<size_t>(last - first), m);
+	}
+
+	thread_local render_target::states_cache render_target::m_states_cache;
+
 	render_target::render_target()
 		: m_projection_needs_update{ true }
+		, m_batching_enabled{ true }
+		, m_deferred_enabled{ false }
+		, m_indirect_enabled{ false }
+		, m_culling_enabled{ false }
 	{}
+
+	render_target::~render_target()
+	{
+		if (m_active_target == this)
+		{
+			m_active_target = nullptr;
+			render_stats::set_current(nullptr);
+		}
+	}
 	
 	int_rect render_target::get_viewport(const view_2d& view) const
 	{
@@ -97,15 +170,15 @@ namespace age
 
 	void render_target::apply_view(const view_2d& value)
 	{
-		// Set the viewport
-		m_viewport = get_viewport(value);
-		int top = static_cast<int>(get_size().y) - (m_viewport.top + m_viewport.height);
-		GL_CALL(glViewport(m_viewport.left, top, m_viewport.width, m_viewport.height));
+		activate();
 
-		// Set the projection matrix
+		// Pending geometry was recorded with the old projection
+		flush();
+
+		m_viewport = get_viewport(value);
 		m_projection_matrix = value.get_transform();
 
-		engine::get_instance()->get_vp_matrix_ubo().buffer_sub_data(0, sizeof(glm::mat4), &m_projection_matrix);
+		apply_viewport();
 
 		m_view_size = value.get_size();
 
@@ -119,6 +192,16 @@ namespace age
 
 	void render_target::draw(const drawable& drawable_object, const render_states& states)
 	{
+		if (m_culling_enabled)
+		{
+			auto bounds = drawable_object.get_cull_bounds();
+			if (bounds && !is_visible(*bounds, states.get_transform()))
+			{
+				++m_stats.culled_draws;
+				return;
+			}
+		}
+
 		drawable_object.draw(*this, states);
 	}
 
@@ -127,8 +210,29 @@ namespace age
 		if (!vertices || !indices || !num_indices)
 			return;
 
-		prepare_draw(vertices, num_vertices, indices, num_indices, states);
-		GL_CALL(glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(num_indices), GL_UNSIGNED_INT, 0));
+		activate();
+
+		if (can_defer(primitive_type::triangles, states))
+		{
+			append_to_queue(vertices, num_vertices, indices, num_indices, states);
+			return;
+		}
+
+		if (can_batch(primitive_type::triangles, states))
+		{
+			append_to_batch(vertices, num_vertices, indices, num_indices, states);
+			return;
+		}
+
+		flush();
+
+		apply_states(states.get_shader_program(), states.get_texture(), states.get_blend_mode(), states.get_transform());
+
+		auto base_vertex = stream_vertices(vertices, num_vertices);
+		auto index_offset = stream_indices(indices, num_indices);
+
+		GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(num_indices), GL_UNSIGNED_INT, reinterpret_cast<void*>(index_offset), static_cast<GLint>(base_vertex)));
+		record_draw(1, num_vertices, num_indices);
 	}
 
 	void render_target::draw(const vertex_2d vertices[], size_t num_vertices, primitive_type type, const render_states& states)
@@ -136,52 +240,597 @@ namespace age
 		if (!vertices || !num_vertices)
 			return;
 
-		prepare_draw(vertices, num_vertices, states);
-		GL_CALL(glDrawArrays(primitive_type_to_GL_constant(type), 0, static_cast<GLsizei>(num_vertices)));
+		activate();
+
+		if (can_defer(type, states))
+		{
+			append_to_queue(vertices, num_vertices, type, states);
+			return;
+		}
+
+		if (can_batch(type, states))
+		{
+			append_to_batch(vertices, num_vertices, type, states);
+			return;
+		}
+
+		flush();
+
+		apply_states(states.get_shader_program(), states.get_texture(), states.get_blend_mode(), states.get_transform());
+
+		auto first_vertex = stream_vertices(vertices, num_vertices);
+
+		GL_CALL(glDrawArrays(primitive_type_to_GL_constant(type), static_cast<GLint>(first_vertex), static_cast<GLsizei>(num_vertices)));
+		record_draw(1, num_vertices, 0);
+	}
+
+	void render_target::draw(const mesh_2d& mesh, const render_states& states)
+	{
+		if (!mesh.get_num_vertices())
+			return;
+
+		activate();
+		flush();
+
+		apply_states(states.get_shader_program(), states.get_texture(), states.get_blend_mode(), states.get_transform());
+
+		mesh.bind();
+
+		if (mesh.is_indexed())
+		{
+			GL_CALL(glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.get_num_indices()), GL_UNSIGNED_INT, 0));
+			record_draw(1, mesh.get_num_vertices(), mesh.get_num_indices());
+			return;
+		}
+
+		GL_CALL(glDrawArrays(primitive_type_to_GL_constant(mesh.get_primitive_type()), 0, static_cast<GLsizei>(mesh.get_num_vertices())));
+		record_draw(1, mesh.get_num_vertices(), 0);
+	}
+
+	void render_target::draw_instanced(const mesh_2d& mesh, size_t num_instances, const render_states& states)
+	{
+		if (!mesh.get_num_vertices() || !num_instances)
+			return;
+
+		activate();
+		flush();
+
+		apply_states(states.get_shader_program(), states.get_texture(), states.get_blend_mode(), states.get_transform());
+
+		mesh.bind();
+
+		if (mesh.is_indexed())
+		{
+			GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(mesh.get_num_indices()), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(num_instances)));
+			record_draw(1, mesh.get_num_vertices() * num_instances, mesh.get_num_indices() * num_instances);
+			return;
+		}
+
+		GL_CALL(glDrawArraysInstanced(primitive_type_to_GL_constant(mesh.get_primitive_type()), 0, static_cast<GLsizei>(mesh.get_num_vertices()), static_cast<GLsizei>(num_instances)));
+		record_draw(1, mesh.get_num_vertices() * num_instances, 0);
+	}
+
+	void render_target::flush()
+	{
+		submit_queue();
+		flush_batch();
+	}
+
+	void render_target::flush_batch()
+	{
+		if (m_batch.indices.empty())
+			return;
+
+		auto base_vertex = stream_vertices(m_batch.vertices.data(), m_batch.vertices.size());
+		auto index_offset = stream_indices(m_batch.indices.data(), m_batch.indices.size());
+
+		if (m_batch.indirect)
+		{
+			submit_indirect_batch(base_vertex, index_offset);
+		}
+		else
+		{
+			apply_states(*m_batch.current_program, *m_batch.current_texture, m_batch.current_blend_mode, glm::mat4{ 1.0f });
+
+			GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(m_batch.indices.size()), GL_UNSIGNED_INT, reinterpret_cast<void*>(index_offset), static_cast<GLint>(base_vertex)));
+			record_draw(1, m_batch.vertices.size(), m_batch.indices.size());
+		}
+
+		m_batch.vertices.clear();
+		m_batch.indices.clear();
+		m_batch.commands.clear();
+		m_batch.transforms.clear();
+	}
+
+	void render_target::submit_indirect_batch(size_t base_vertex, size_t index_offset)
+	{
+		auto engine = engine::get_instance();
+
+		for (auto& command : m_batch.commands)
+		{
+			command.first_index += static_cast<uint32_t>(index_offset / sizeof(uint32_t));
+			command.base_vertex += static_cast<int32_t>(base_vertex);
+		}
+
+		//The model matrix block is not used by the indirect program, so the cached transform is passed to skip its upload
+		apply_states(engine->get_indirect_shader_program(), *m_batch.current_texture, m_batch.current_blend_mode, m_states_cache.last_transform);
+
+		auto& transform_buffer = engine->get_draw_transform_buffer_object();
+		auto transforms_size = m_batch.transforms.size() * sizeof(glm::mat4);
+		auto transforms_offset = transform_buffer.stream_data(m_batch.transforms.data(), transforms_size, engine->get_shader_storage_offset_alignment());
+		transform_buffer.bind_range(engine::get_draw_transform_binding(), transforms_offset, transforms_size);
+
+		auto& indirect_buffer = engine->get_draw_indirect_buffer_object();
+		auto commands_offset = indirect_buffer.stream_data(m_batch.commands.data(), m_batch.commands.size() * sizeof(draw_elements_indirect_command), sizeof(uint32_t));
+		indirect_buffer.bind();
+
+		GL_CALL(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<void*>(commands_offset), static_cast<GLsizei>(m_batch.commands.size()), 0));
+		record_draw(1, m_batch.vertices.size(), m_batch.indices.size());
+	}
+
+	const render_stats& render_target::get_stats() const
+	{
+		return m_last_frame_stats;
+	}
+
+	void render_target::finish_frame_stats()
+	{
+		m_stats.gl_error_checks = gl_error_check_count - m_gl_error_check_count_at_frame_start;
+
+		m_last_frame_stats = m_stats;
+		m_stats.reset();
+
+		m_gl_error_check_count_at_frame_start = gl_error_check_count;
+	}
+
+	void render_target::set_batching_enabled(bool value)
+	{
+		if (!value)
+			flush();
+
+		m_batching_enabled = value;
+	}
+
+	bool render_target::is_batching_enabled() const
+	{
+		return m_batching_enabled;
+	}
+
+	void render_target::set_deferred_enabled(bool value)
+	{
+		if (!value)
+			flush();
+
+		m_deferred_enabled = value;
+	}
+
+	bool render_target::is_deferred_enabled() const
+	{
+		return m_deferred_enabled;
+	}
+
+	void render_target::set_indirect_enabled(bool value)
+	{
+		flush();
+
+		m_indirect_enabled = value;
+	}
+
+	bool render_target::is_indirect_enabled() const
+	{
+		return m_indirect_enabled;
+	}
+
+	void render_target::set_culling_enabled(bool value)
+	{
+		m_culling_enabled = value;
+	}
+
+	bool render_target::is_culling_enabled() const
+	{
+		return m_culling_enabled;
 	}
 
 	void render_target::init()
 	{
-		GL_CALL(glEnable(GL_BLEND));
+		gl_state::get_current().set_enabled(GL_BLEND, true);
 		apply_blend_mode(blend_mode::blend_alpha);
 	}
 
-	void render_target::prepare_draw(const vertex_2d vertices[], size_t num_vertices, const render_states& states)
+	void render_target::activate()
 	{
-		auto& program = states.get_shader_program();
+		if (m_active_target == this)
+			return;
 
-		program.bind();
+		if (m_active_target)
+			m_active_target->flush();
+
+		m_active_target = this;
+		render_stats::set_current(&m_stats);
+
+		gl_state::get_current().bind_framebuffer(GL_FRAMEBUFFER, get_framebuffer_id());
 
-		engine::get_instance()->get_model_matrix_ubo().buffer_sub_data(0, sizeof(glm::mat4), &states.get_transform());
+		// Viewport and projection are global state, which the previous target may have changed
+		apply_viewport();
+	}
 
-		states.get_texture().bind();
+	uint32_t render_target::get_framebuffer_id() const
+	{
+		return 0;
+	}
 
-		engine::get_instance()->get_default_vertex_buffer_object().update_data(vertices, num_vertices * sizeof(vertex_2d), age::vertex_buffer_object::usage::stream_draw);
+	void render_target::flush_pending_draws(const shader_program& program)
+	{
+		auto target = m_active_target;
+		if (!target)
+			return;
 
-		apply_blend_mode(states.get_blend_mode());
+		bool batched = !target->m_batch.indices.empty() && target->m_batch.current_program == &program;
+		bool queued = std::find(target->m_queue.programs.begin(), target->m_queue.programs.end(), &program) != target->m_queue.programs.end();
+
+		if (batched || queued)
+			target->flush();
 	}
 
-	void render_target::prepare_draw(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices, const render_states& states)
+	void render_target::flush_pending_draws(const texture& tex)
 	{
-		engine::get_instance()->get_default_element_buffer_object().update_data(indices, num_indices * sizeof(uint32_t), age::vertex_buffer_object::usage::stream_draw);
+		auto target = m_active_target;
+		if (!target)
+			return;
 
-		prepare_draw(vertices, num_vertices, states);
+		bool batched = !target->m_batch.indices.empty() && target->m_batch.current_texture == &tex;
+		bool queued = target->m_queue.textures.find(&tex) != target->m_queue.textures.end();
+
+		if (batched || queued)
+			target->flush();
 	}
 
-	void render_target::apply_blend_mode(const blend_mode& mode)
+	void render_target::release_active_target()
+	{
+		if (m_active_target)
+			m_active_target->flush();
+
+		m_active_target = nullptr;
+		render_stats::set_current(nullptr);
+	}
+
+	bool render_target::is_visible(const float_rect& bounds, const glm::mat4& transform) const
+	{
+		glm::mat4 clip_transform = m_projection_matrix * transform;
+		auto clip_bounds = transform_rect(clip_transform, bounds);
+
+		return clip_bounds.left <= 1.0f && clip_bounds.left + clip_bounds.width >= -1.0f
+			&& clip_bounds.top <= 1.0f && clip_bounds.top + clip_bounds.height >= -1.0f;
+	}
+
+	bool render_target::can_batch(primitive_type type, const render_states& states) const
+	{
+		if (!m_batching_enabled || !states.get_batching())
+			return false;
+
+		//Per draw uniform blocks belong to exactly one draw
+		if (states.get_shader_program().has_uniform_block_data())
+			return false;
+
+		return is_triangle_type(type);
+	}
+
+	bool render_target::is_batch_compatible(size_t num_vertices, const shader_program& program, const texture& tex, const blend_mode& mode) const
+	{
+		if (m_batch.indices.empty())
+			return true;
+
+		return m_batch.current_program == &program
+			&& m_batch.current_texture == &tex
+			&& m_batch.current_blend_mode == mode
+			&& m_batch.vertices.size() + num_vertices <= max_batch_vertices;
+	}
+
+	void render_target::append_to_batch(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices, const render_states& states)
+	{
+		auto base_index = begin_batch_draw(vertices, num_vertices, states.get_shader_program(), states.get_texture(), states.get_blend_mode(), states.get_transform());
+
+		for (size_t i = 0; i < num_indices; ++i)
+			m_batch.indices.push_back(base_index + indices[i]);
+
+		end_batch_draw();
+	}
+
+	void render_target::append_to_batch(const vertex_2d vertices[], size_t num_vertices, primitive_type type, const render_states& states)
+	{
+		if (num_vertices < 3)
+			return;
+
+		auto base_index = begin_batch_draw(vertices, num_vertices, states.get_shader_program(), states.get_texture(), states.get_blend_mode(), states.get_transform());
+
+		append_triangle_list_indices(m_batch.indices, base_index, static_cast<uint32_t>(num_vertices), type);
+
+		end_batch_draw();
+	}
+
+	uint32_t render_target::begin_batch_draw(const vertex_2d vertices[], size_t num_vertices, const shader_program& program, const texture& tex, const blend_mode& mode, const glm::mat4& transform)
+	{
+		if (!is_batch_compatible(num_vertices, program, tex, mode))
+			flush_batch();
+
+		m_batch.current_program = &program;
+		m_batch.current_texture = &tex;
+		m_batch.current_blend_mode = mode;
+		m_batch.indirect = uses_indirect(program);
+
+		auto first = m_batch.vertices.size();
+		m_batch.vertices.insert(m_batch.vertices.end(), vertices, vertices + num_vertices);
+
+		m_batch.draw_first_vertex = first;
+		m_batch.draw_first_index = m_batch.indices.size();
+
+		//Indirect draws keep their own base vertex and transform, so their indices stay relative to their first vertex
+		if (m_batch.indirect)
+		{
+			m_batch.transforms.push_back(transform);
+			return 0;
+		}
+
+		transform_vertices(m_batch.vertices.data() + first, m_batch.vertices.data() + m_batch.vertices.size(), transform);
+
+		return static_cast<uint32_t>(first);
+	}
+
+	void render_target::end_batch_draw()
 	{
-		if (mode != m_states_cache.last_blend_mode)
+		if (!m_batch.indirect)
+			return;
+
+		m_batch.commands.push_back(draw_elements_indirect_command
 		{
-			GL_CALL(glBlendFuncSeparate(factor_to_GL_constant(mode.color_src_factor),
-				factor_to_GL_constant(mode.color_dst_factor),
-				factor_to_GL_constant(mode.alpha_src_factor),
-				factor_to_GL_constant(mode.alpha_dst_factor)));
+			static_cast<uint32_t>(m_batch.indices.size() - m_batch.draw_first_index),
+			1,
+			static_cast<uint32_t>(m_batch.draw_first_index),
+			static_cast<int32_t>(m_batch.draw_first_vertex),
+			static_cast<uint32_t>(m_batch.transforms.size() - 1)
+		});
+	}
 
-			GL_CALL(glBlendEquationSeparate(equation_to_GL_constant(mode.color_equation),
-				equation_to_GL_constant(mode.alpha_equation)));
+	bool render_target::uses_indirect(const shader_program& program) const
+	{
+		auto engine = engine::get_instance();
+
+		//Without gl_DrawIDARB the shader can't look up the transforms, every draw would need its own model matrix and draw call.
+		//Transforming on the CPU keeps the batch in one draw call instead
+		return m_indirect_enabled && engine->has_shader_draw_parameters() && &program == &engine->get_default_shader_program();
+	}
+
+	bool render_target::can_defer(primitive_type type, const render_states& states) const
+	{
+		if (!m_deferred_enabled || !states.get_batching())
+			return false;
+
+		if (states.get_shader_program().has_uniform_block_data())
+			return false;
+
+		return is_triangle_type(type);
+	}
+
+	void render_target::append_to_queue(const vertex_2d vertices[], size_t num_vertices, const uint32_t indices[], size_t num_indices, const render_states& states)
+	{
+		auto& command = push_queued_command(vertices, num_vertices, states);
+
+		m_queue.indices.insert(m_queue.indices.end(), indices, indices + num_indices);
+		command.num_indices = num_indices;
+	}
+
+	void render_target::append_to_queue(const vertex_2d vertices[], size_t num_vertices, primitive_type type, const render_states& states)
+	{
+		if (num_vertices < 3)
+			return;
+
+		auto& command = push_queued_command(vertices, num_vertices, states);
+
+		append_triangle_list_indices(m_queue.indices, 0, static_cast<uint32_t>(num_vertices), type);
+		command.num_indices = m_queue.indices.size() - command.first_index;
+	}
 
-			m_states_cache.last_blend_mode = mode;
+	render_target::queued_command& render_target::push_queued_command(const vertex_2d vertices[], size_t num_vertices, const render_states& states)
+	{
+		auto key = make_sort_key(states);
+
+		m_queue.keys.push_back(radix_sort_item{ key, static_cast<uint32_t>(m_queue.commands.size()) });
+
+		auto first_vertex = m_queue.vertices.size();
+		m_queue.vertices.insert(m_queue.vertices.end(), vertices, vertices + num_vertices);
+
+		transform_vertices(m_queue.vertices.data() + first_vertex, m_queue.vertices.data() + m_queue.vertices.size(), states.get_transform());
+
+		return m_queue.commands.emplace_back(queued_command{ &states.get_shader_program(), &states.get_texture(), states.get_blend_mode(), first_vertex, num_vertices, m_queue.indices.size(), 0 });
+	}
+
+	uint64_t render_target::make_sort_key(const render_states& states)
+	{
+		auto* program = &states.get_shader_program();
+		auto* tex = &states.get_texture();
+		const auto& mode = states.get_blend_mode();
+
+		auto program_it = std::find(m_queue.programs.begin(), m_queue.programs.end(), program);
+		auto texture_it = m_queue.textures.find(tex);
+		auto blend_mode_it = std::find(m_queue.blend_modes.begin(), m_queue.blend_modes.end(), mode);
+
+		//Submit early if one of the ids would not fit into its bits anymore
+		if ((program_it == m_queue.programs.end() && m_queue.programs.size() == max_queued_programs)
+			|| (texture_it == m_queue.textures.end() && m_queue.textures.size() == max_queued_textures)
+			|| (blend_mode_it == m_queue.blend_modes.end() && m_queue.blend_modes.size() == max_queued_blend_modes)
+			|| m_queue.commands.size() == max_queued_commands)
+		{
+			submit_queue();
+
+			program_it = m_queue.programs.end();
+			texture_it = m_queue.textures.end();
+			blend_mode_it = m_queue.blend_modes.end();
 		}
+
+		uint64_t program_id = program_it - m_queue.programs.begin();
+		if (program_it == m_queue.programs.end())
+			m_queue.programs.push_back(program);
+
+		uint64_t texture_id = m_queue.textures.size();
+		if (texture_it == m_queue.textures.end())
+			m_queue.textures.emplace(tex, static_cast<uint32_t>(texture_id));
+		else
+			texture_id = texture_it->second;
+
+		uint64_t blend_mode_id = blend_mode_it - m_queue.blend_modes.begin();
+		if (blend_mode_it == m_queue.blend_modes.end())
+			m_queue.blend_modes.push_back(mode);
+
+		uint64_t layer = states.get_layer();
+		uint64_t sequence = m_queue.commands.size();
+		bool translucent = mode != blend_mode::blend_none && !states.get_opaque();
+
+		//Key layout from the most significant bit: layer (8) | translucent (1) | program (8) | texture (16) | blend mode (6) | sequence (24)
+		//Translucent draws put the sequence in front of the states, so they are drawn in submission order within their layer
+		uint64_t state_bits = (program_id << 22) | (texture_id << 6) | blend_mode_id;
+		uint64_t order_bits = translucent ? (sequence << 30) | state_bits : (state_bits << 24) | sequence;
+
+		return (layer << 55) | (static_cast<uint64_t>(translucent) << 54) | order_bits;
+	}
+
+	void render_target::submit_queue()
+	{
+		if (m_queue.commands.empty())
+			return;
+
+		radix_sort(m_queue.keys, m_queue.scratch);
+
+		//Sorted commands with equal states end up next to each other and are merged by the batch
+		for (const auto& item : m_queue.keys)
+		{
+			const auto& command = m_queue.commands[item.value];
+
+			//Queued vertices have already been transformed
+			auto base_index = begin_batch_draw(m_queue.vertices.data() + command.first_vertex, command.num_vertices, *command.program, *command.tex, command.mode, glm::mat4{ 1.0f });
+
+			for (size_t i = 0; i < command.num_indices; ++i)
+				m_batch.indices.push_back(base_index + m_queue.indices[command.first_index + i]);
+
+			end_batch_draw();
+		}
+
+		m_queue.commands.clear();
+		m_queue.vertices.clear();
+		m_queue.indices.clear();
+		m_queue.keys.clear();
+		m_queue.programs.clear();
+		m_queue.textures.clear();
+		m_queue.blend_modes.clear();
+	}
+
+	size_t render_target::stream_vertices(const vertex_2d vertices[], size_t num_vertices)
+	{
+		auto engine = engine::get_instance();
+		auto& vertex_buffer = engine->get_default_vertex_buffer_object();
+
+		engine->get_default_vertex_array_object().bind();
+
+		auto offset = vertex_buffer.stream_data(vertices, num_vertices * sizeof(vertex_2d), sizeof(vertex_2d));
+
+		//Growing the stream replaces the buffer, so the attribute pointers need to be set again
+		if (vertex_buffer.get_id() != m_states_cache.last_vertex_buffer_id)
+		{
+			engine->apply_default_vertex_layout();
+			m_states_cache.last_vertex_buffer_id = vertex_buffer.get_id();
+		}
+
+		return offset / sizeof(vertex_2d);
+	}
+
+	size_t render_target::stream_indices(const uint32_t indices[], size_t num_indices)
+	{
+		auto& element_buffer = engine::get_instance()->get_default_element_buffer_object();
+
+		auto offset = element_buffer.stream_data(indices, num_indices * sizeof(uint32_t), sizeof(uint32_t));
+		element_buffer.bind();
+
+		return offset;
+	}
+
+	void render_target::apply_states(const shader_program& program, const texture& tex, const blend_mode& mode, const glm::mat4& transform)
+	{
+		auto engine = engine::get_instance();
+
+		program.bind();
+
+		//The matrices and uniform blocks are streamed into the uniform ring, so no draw waits for the GPU to finish reading the previous value.
+		//Once the ring moved on to another region the old ranges may be overwritten. Streaming one range can move the ring on, so all of them
+		//are streamed again until they lie in the same region
+		auto& ring = engine->get_uniform_stream_buffer_object();
+		auto& state = gl_state::get_current();
+		size_t alignment = engine->get_uniform_buffer_offset_alignment();
+
+		for (;;)
+		{
+			uint64_t generation = ring.get_stream_generation();
+			bool ranges_valid = generation == m_states_cache.last_uniform_generation;
+
+			program.apply_uniform_block_data();
+
+			//Another context or a per draw block may have bound something else in the meantime
+			bool transform_bound = state.is_buffer_range_bound(GL_UNIFORM_BUFFER, engine::get_model_matrix_binding(), ring.get_id(), m_states_cache.last_transform_offset, sizeof(glm::mat4));
+			if (!ranges_valid || !transform_bound || transform != m_states_cache.last_transform)
+			{
+				m_states_cache.last_transform_offset = ring.stream_data(&transform, sizeof(glm::mat4), alignment);
+				ring.bind_range(engine::get_model_matrix_binding(), m_states_cache.last_transform_offset, sizeof(glm::mat4));
+				m_states_cache.last_transform = transform;
+			}
+
+			glm::mat4 texture_matrix = tex.get_texture_matrix();
+			bool texture_matrix_bound = state.is_buffer_range_bound(GL_UNIFORM_BUFFER, engine::get_texture_matrix_binding(), ring.get_id(), m_states_cache.last_texture_matrix_offset, sizeof(glm::mat4));
+			if (!ranges_valid || !texture_matrix_bound || texture_matrix != m_states_cache.last_texture_matrix)
+			{
+				m_states_cache.last_texture_matrix_offset = ring.stream_data(&texture_matrix, sizeof(glm::mat4), alignment);
+				ring.bind_range(engine::get_texture_matrix_binding(), m_states_cache.last_texture_matrix_offset, sizeof(glm::mat4));
+				m_states_cache.last_texture_matrix = texture_matrix;
+			}
+
+			m_states_cache.last_uniform_generation = generation;
+
+			//A fresh region fits all ranges, so this repeats at most once
+			if (ring.get_stream_generation() == generation)
+				break;
+		}
+
+		tex.bind();
+
+		apply_blend_mode(mode);
+	}
+
+	void render_target::apply_blend_mode(const blend_mode& mode)
+	{
+		auto& state = gl_state::get_current();
+
+		bool changed = state.set_blend_func(factor_to_GL_constant(mode.color_src_factor),
+			factor_to_GL_constant(mode.color_dst_factor),
+			factor_to_GL_constant(mode.alpha_src_factor),
+			factor_to_GL_constant(mode.alpha_dst_factor));
+
+		changed |= state.set_blend_equation(equation_to_GL_constant(mode.color_equation),
+			equation_to_GL_constant(mode.alpha_equation));
+
+		if (changed)
+			++m_stats.blend_changes;
+	}
+
+	void render_target::record_draw(size_t num_draw_calls, size_t num_vertices, size_t num_indices)
+	{
+		m_stats.draw_calls += static_cast<uint32_t>(num_draw_calls);
+		m_stats.vertices += num_vertices;
+		m_stats.indices += num_indices;
+	}
+
+	void render_target::apply_viewport()
+	{
+		int top = static_cast<int>(get_size().y) - (m_viewport.top + m_viewport.height);
+		gl_state::get_current().set_viewport(m_viewport.left, top, m_viewport.width, m_viewport.height);
+
+		engine::get_instance()->get_vp_matrix_ubo().buffer_sub_data(0, sizeof(glm::mat4), &m_projection_matrix);
 	}
 
 	const glm::mat4& render_target::get_inverse_projection() const
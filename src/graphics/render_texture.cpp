@@ -0,0 +1,212 @@
+#include "graphics/render_texture.h"
+
+#include <glad/glad.h>
+
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <array>
+
+#include "graphics/gl_state.h"
+#include "utility/gl_check.h"
+
+namespace age
+{
+	render_texture::render_texture()
+	{}
+
+	void render_texture::create(const glm::u32vec2& size, uint32_t samples, bool depth_stencil)
+	{
+		//Pending draws must not end up in the new framebuffer
+		release_active_target();
+
+		m_texture.create(size);
+		m_texture.set_pixels_flipped(true);
+
+		m_framebuffer.reset(create_framebuffer());
+		m_resolve_framebuffer.reset(0);
+		m_color_renderbuffer.reset(0);
+		m_depth_stencil_renderbuffer.reset(0);
+
+		if (samples > 0)
+		{
+			GLint max_samples = 0;
+			GL_CALL(glGetIntegerv(GL_MAX_SAMPLES, &max_samples));
+			samples = std::min(samples, static_cast<uint32_t>(max_samples));
+		}
+
+		m_samples = samples;
+		m_depth_stencil = depth_stencil;
+
+		gl_state::get_current().bind_framebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+		if (m_samples > 0)
+		{
+			m_color_renderbuffer.reset(create_renderbuffer());
+
+			GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, m_color_renderbuffer));
+			GL_CALL(glRenderbufferStorageMultisample(GL_RENDERBUFFER, static_cast<GLsizei>(m_samples), GL_RGBA8, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y)));
+			GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color_renderbuffer));
+		}
+		else
+		{
+			GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture.get_id(), 0));
+		}
+
+		if (m_depth_stencil)
+		{
+			m_depth_stencil_renderbuffer.reset(create_renderbuffer());
+
+			GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, m_depth_stencil_renderbuffer));
+
+			if (m_samples > 0)
+			{
+				GL_CALL(glRenderbufferStorageMultisample(GL_RENDERBUFFER, static_cast<GLsizei>(m_samples), GL_DEPTH24_STENCIL8, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y)));
+			}
+			else
+			{
+				GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y)));
+			}
+
+			GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth_stencil_renderbuffer));
+		}
+
+		check_framebuffer_status();
+
+		if (m_samples > 0)
+		{
+			m_resolve_framebuffer.reset(create_framebuffer());
+
+			gl_state::get_current().bind_framebuffer(GL_FRAMEBUFFER, m_resolve_framebuffer);
+			GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture.get_id(), 0));
+
+			check_framebuffer_status();
+
+			gl_state::get_current().bind_framebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		}
+
+		glm::vec2 view_size{ 1.0f, static_cast<float>(size.y) / static_cast<float>(size.x) };
+		view_2d view{ view_size * 0.5f, view_size };
+
+		apply_view(view);
+	}
+
+	void render_texture::clear(const color& clear_color)
+	{
+		activate();
+		flush();
+
+		//glClearBuffer leaves the clear color of the window untouched
+		std::array<GLfloat, 4> rgba{ clear_color.r / 255.0f, clear_color.g / 255.0f, clear_color.b / 255.0f, clear_color.a / 255.0f };
+		GL_CALL(glClearBufferfv(GL_COLOR, 0, rgba.data()));
+
+		if (m_depth_stencil)
+			GL_CALL(glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0));
+	}
+
+	void render_texture::display()
+	{
+		activate();
+		flush();
+
+		if (m_samples > 0)
+		{
+			auto size = m_texture.get_size();
+
+			gl_state::get_current().bind_framebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+			gl_state::get_current().bind_framebuffer(GL_DRAW_FRAMEBUFFER, m_resolve_framebuffer);
+			GL_CALL(glBlitFramebuffer(0, 0, static_cast<GLint>(size.x), static_cast<GLint>(size.y), 0, 0, static_cast<GLint>(size.x), static_cast<GLint>(size.y), GL_COLOR_BUFFER_BIT, GL_NEAREST));
+			gl_state::get_current().bind_framebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		}
+
+		if (m_texture.m_has_mipmap)
+			m_texture.invalidate_mipmap();
+
+		finish_frame_stats();
+	}
+
+	const texture& render_texture::get_texture() const
+	{
+		return m_texture;
+	}
+
+	void render_texture::set_smooth(bool value)
+	{
+		m_texture.set_smooth(value);
+	}
+
+	bool render_texture::get_smooth() const
+	{
+		return m_texture.get_smooth();
+	}
+
+	void render_texture::set_repeat(bool value)
+	{
+		m_texture.set_repeat(value);
+	}
+
+	bool render_texture::get_repeat() const
+	{
+		return m_texture.get_repeat();
+	}
+
+	uint32_t render_texture::get_samples() const
+	{
+		return m_samples;
+	}
+
+	bool render_texture::has_depth_stencil() const
+	{
+		return m_depth_stencil;
+	}
+
+	glm::u32vec2 render_texture::get_size() const
+	{
+		return m_texture.get_size();
+	}
+
+	uint32_t render_texture::get_framebuffer_id() const
+	{
+		return m_framebuffer;
+	}
+
+	uint32_t render_texture::create_framebuffer()
+	{
+		GLuint handle;
+		GL_CALL(glGenFramebuffers(1, &handle));
+
+		return handle;
+	}
+
+	void render_texture::delete_framebuffer(uint32_t handle)
+	{
+		gl_state::get_current().forget_framebuffer(handle);
+		GL_CALL(glDeleteFramebuffers(1, &handle));
+	}
+
+	uint32_t render_texture::create_renderbuffer()
+	{
+		GLuint handle;
+		GL_CALL(glGenRenderbuffers(1, &handle));
+
+		return handle;
+	}
+
+	void render_texture::delete_renderbuffer(uint32_t handle)
+	{
+		GL_CALL(glDeleteRenderbuffers(1, &handle));
+	}
+
+	void render_texture::check_framebuffer_status()
+	{
+		GLenum status = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::stringstream message;
+			message << "Failed to create render texture: framebuffer is incomplete (0x" << std::hex << status << ")";
+
+			throw std::runtime_error{ message.str() };
+		}
+	}
+}
@@ -8,13 +8,16 @@
 #include <sstream>
 #include <string_view>
 #include <stdexcept>
+#include <cstdio>
 
 #include <utility/gl_check.h>
+#include "graphics/gl_state.h"
 
 namespace age
 {
 	render_window::render_window()
 		: m_clear_flags{ GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT }
+		, m_headless{ get_headless_request().has_value() }
 	{
 		if (SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1) < 0)
 		{
@@ -36,8 +39,8 @@ namespace age
 		//For testing purpose only as multithreeaded OpenGL has ome issues on Wayland
 		//m_context.acquire_shared_context();
 
-		//Use Vsync
-		if (SDL_GL_SetSwapInterval(1) < 0)
+		//Use Vsync. Headless windows never present, so they render as fast as possible
+		if (!m_headless && SDL_GL_SetSwapInterval(1) < 0)
 		{
 			SDL_LogWarn(SDL_LOG_CATEGORY_RENDER, "Warning: Unable to set VSync! SDL Error: %s", SDL_GetError());
 		}
@@ -54,6 +57,26 @@ namespace age
 	{
 		auto handle = static_cast<SDL_Window*>(m_windowhandle.get());
 
+		if (m_headless)
+		{
+			auto requested_size = *get_headless_request();
+			if (requested_size.x == 0 || requested_size.y == 0)
+				requested_size = glm::u32vec2{ width, height };
+
+			width = requested_size.x;
+			height = requested_size.y;
+
+			SDL_SetWindowTitle(handle, title.data());
+			SDL_SetWindowSize(handle, static_cast<int>(width), static_cast<int>(height));
+
+			create_headless_framebuffer(requested_size);
+
+			glm::vec2 view_size{ 1.0f, static_cast<float>(height) / static_cast<float>(width) };
+			apply_view(view_2d{ view_size * 0.5f, view_size });
+
+			return;
+		}
+
 		SDL_SetWindowTitle(handle, title.data());
 		SDL_SetWindowSize(handle , width, height);
 		SDL_SetWindowPosition(handle, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
@@ -98,16 +121,35 @@ namespace age
 
 	void render_window::clear()
 	{
+		activate();
+		flush();
+
 		GL_CALL(glClear(m_clear_flags));
 	}
 
 	void render_window::display()
 	{
+		activate();
+		flush();
+
+		finish_frame_stats();
+
+		if (m_headless)
+		{
+			if (m_capture_callback)
+				m_capture_callback(*this);
+
+			return;
+		}
+
 		SDL_GL_SwapWindow(static_cast<SDL_Window*>(m_windowhandle.get()));
 	}
 
 	glm::u32vec2 render_window::get_size() const
 	{
+		if (m_headless)
+			return m_headless_size;
+
 		int w;
 		int h;
 
@@ -116,8 +158,120 @@ namespace age
 		return glm::u32vec2{ static_cast<uint32_t>(w), static_cast<uint32_t>(h) };
 	}
 
+	bool render_window::is_headless() const
+	{
+		return m_headless;
+	}
+
+	void render_window::set_capture_callback(capture_callback callback)
+	{
+		m_capture_callback = std::move(callback);
+	}
+
+	image render_window::capture()
+	{
+		activate();
+		flush();
+
+		auto size = get_size();
+		std::vector<uint8_t> pixels(static_cast<size_t>(size.x) * size.y * 4);
+
+		GLint previous_read_frame_buffer;
+		GL_CALL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_frame_buffer));
+
+		gl_state::get_current().bind_framebuffer(GL_READ_FRAMEBUFFER, get_framebuffer_id());
+		GL_CALL(glReadPixels(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		gl_state::get_current().bind_framebuffer(GL_READ_FRAMEBUFFER, static_cast<uint32_t>(previous_read_frame_buffer));
+
+		image result;
+		result.create(size, pixels.data());
+
+		//Framebuffers are stored bottom up
+		result.flip_vertical();
+
+		return result;
+	}
+
+	void render_window::prewarm_shared_contexts(size_t count)
+	{
+		m_context.prewarm_shared_contexts(count);
+	}
+
+	std::optional<glm::u32vec2> render_window::get_headless_request()
+	{
+		const char* value = SDL_getenv("APOLLO_HEADLESS");
+
+		if (!value || !*value || std::string_view{ value } == "0")
+			return std::nullopt;
+
+		//A size of zero means that the size passed to engine::start is used
+		unsigned int width = 0;
+		unsigned int height = 0;
+
+		if (std::sscanf(value, "%ux%u", &width, &height) != 2)
+			return glm::u32vec2{ 0, 0 };
+
+		return glm::u32vec2{ width, height };
+	}
+
+	uint32_t render_window::get_framebuffer_id() const
+	{
+		return m_headless_framebuffer;
+	}
+
 	void render_window::destroy_window_lib(void* window)
 	{
 		SDL_DestroyWindow(static_cast<SDL_Window*>(window));
 	}
+
+	uint32_t render_window::create_framebuffer()
+	{
+		GLuint handle;
+		GL_CALL(glGenFramebuffers(1, &handle));
+
+		return handle;
+	}
+
+	void render_window::delete_framebuffer(uint32_t handle)
+	{
+		gl_state::get_current().forget_framebuffer(handle);
+		GL_CALL(glDeleteFramebuffers(1, &handle));
+	}
+
+	uint32_t render_window::create_renderbuffer()
+	{
+		GLuint handle;
+		GL_CALL(glGenRenderbuffers(1, &handle));
+
+		return handle;
+	}
+
+	void render_window::delete_renderbuffer(uint32_t handle)
+	{
+		GL_CALL(glDeleteRenderbuffers(1, &handle));
+	}
+
+	void render_window::create_headless_framebuffer(const glm::u32vec2& size)
+	{
+		release_active_target();
+
+		m_headless_size = size;
+
+		m_headless_framebuffer.reset(create_framebuffer());
+		m_headless_color_renderbuffer.reset(create_renderbuffer());
+		m_headless_depth_stencil_renderbuffer.reset(create_renderbuffer());
+
+		gl_state::get_current().bind_framebuffer(GL_FRAMEBUFFER, m_headless_framebuffer);
+
+		GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, m_headless_color_renderbuffer));
+		GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y)));
+		GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_headless_color_renderbuffer));
+
+		GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, m_headless_depth_stencil_renderbuffer));
+		GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y)));
+		GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_headless_depth_stencil_renderbuffer));
+
+		if (GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER)) != GL_FRAMEBUFFER_COMPLETE)
+			throw std::runtime_error{ "Failed to create headless framebuffer" };
+	}
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "graphics/scene_graph.h"
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "graphics/render_target.h"
+#include "graphics/render_states.h"
+
+namespace age
+{
+	constexpr uint32_t null_slot = ~uint32_t{ 0 };
+
+	scene_graph::node_id scene_graph::create_node(node_id parent, const drawable* drawable_object)
+	{
+		uint32_t parent_slot = parent == null_node ? null_slot : get_slot(parent);
+
+		node_id id;
+		if (!m_free_ids.empty())
+		{
+			id = m_free_ids.back();
+			m_free_ids.pop_back();
+		}
+		else
+		{
+			id = static_cast<node_id>(m_slots.size());
+			m_slots.push_back(null_slot);
+		}
+
+		//Appending keeps every parent in front of its children
+		m_slots[id] = static_cast<uint32_t>(m_ids.size());
+		m_ids.push_back(id);
+		m_parents.push_back(parent_slot);
+		m_locals.emplace_back();
+		m_drawables.push_back(drawable_object);
+		m_worlds.emplace_back(1.0f);
+		m_dirty.push_back(1);
+		m_changed.push_back(0);
+
+		m_world_transforms_need_update = true;
+
+		return id;
+	}
+
+	void scene_graph::destroy_node(node_id id)
+	{
+		uint32_t slot = get_slot(id);
+
+		//Parents are in front of their children, so one pass from the node on finds the whole subtree
+		std::vector<uint8_t> removed(m_ids.size(), 0);
+		removed[slot] = 1;
+
+		for (uint32_t i = slot + 1; i < m_ids.size(); ++i)
+		{
+			uint32_t parent = m_parents[i];
+			removed[i] = parent != null_slot && parent >= slot && removed[parent];
+		}
+
+		sort_nodes(removed);
+	}
+
+	void scene_graph::clear()
+	{
+		m_ids.clear();
+		m_parents.clear();
+		m_locals.clear();
+		m_drawables.clear();
+		m_worlds.clear();
+		m_dirty.clear();
+		m_changed.clear();
+		m_slots.clear();
+		m_free_ids.clear();
+
+		m_world_transforms_need_update = false;
+	}
+
+	void scene_graph::set_parent(node_id id, node_id parent)
+	{
+		uint32_t slot = get_slot(id);
+		uint32_t parent_slot = parent == null_node ? null_slot : get_slot(parent);
+
+		for (uint32_t ancestor = parent_slot; ancestor != null_slot; ancestor = m_parents[ancestor])
+		{
+			if (ancestor == slot)
+				throw std::runtime_error{ "SCENE_GRAPH::SET_PARENT NODE CAN NOT BECOME A CHILD OF ITS OWN SUBTREE!" };
+		}
+
+		m_parents[slot] = parent_slot;
+		m_dirty[slot] = 1;
+		m_world_transforms_need_update = true;
+
+		if (parent_slot != null_slot && parent_slot > slot)
+			sort_nodes(std::vector<uint8_t>(m_ids.size(), 0));
+	}
+
+	scene_graph::node_id scene_graph::get_parent(node_id id) const
+	{
+		uint32_t parent_slot = m_parents[get_slot(id)];
+
+		return parent_slot == null_slot ? null_node : m_ids[parent_slot];
+	}
+
+	void scene_graph::set_drawable(node_id id, const drawable* value)
+	{
+		m_drawables[get_slot(id)] = value;
+	}
+
+	const drawable* scene_graph::get_drawable(node_id id) const
+	{
+		return m_drawables[get_slot(id)];
+	}
+
+	const transformable_2d& scene_graph::get_local(node_id id) const
+	{
+		return m_locals[get_slot(id)];
+	}
+
+	transformable_2d& scene_graph::edit_local(node_id id)
+	{
+		uint32_t slot = get_slot(id);
+
+		m_dirty[slot] = 1;
+		m_world_transforms_need_update = true;
+
+		return m_locals[slot];
+	}
+
+	const glm::mat4& scene_graph::get_world_transform(node_id id) const
+	{
+		ensure_world_transforms_are_updated();
+
+		return m_worlds[get_slot(id)];
+	}
+
+	void scene_graph::draw_subtree(render_target& target, node_id id, const render_states& states) const
+	{
+		ensure_world_transforms_are_updated();
+
+		uint32_t slot = get_slot(id);
+		bool has_base_transform = states.get_transform() != glm::mat4{ 1.0f };
+		render_states node_states = states;
+
+		//m_changed is free between updates, so it marks the members of the subtree here
+		m_changed[slot] = 1;
+
+		for (uint32_t i = slot; i < m_ids.size(); ++i)
+		{
+			if (i != slot)
+			{
+				uint32_t parent = m_parents[i];
+				m_changed[i] = parent != null_slot && parent >= slot && m_changed[parent];
+			}
+
+			if (!m_changed[i] || !m_drawables[i])
+				continue;
+
+			node_states.set_transform(has_base_transform ? states.get_transform() * m_worlds[i] : m_worlds[i]);
+			target.draw(*m_drawables[i], node_states);
+		}
+	}
+
+	size_t scene_graph::get_size() const
+	{
+		return m_ids.size();
+	}
+
+	void scene_graph::draw(render_target& target, const render_states& states) const
+	{
+		ensure_world_transforms_are_updated();
+
+		bool has_base_transform = states.get_transform() != glm::mat4{ 1.0f };
+		render_states node_states = states;
+
+		for (uint32_t i = 0; i < m_ids.size(); ++i)
+		{
+			if (!m_drawables[i])
+				continue;
+
+			node_states.set_transform(has_base_transform ? states.get_transform() * m_worlds[i] : m_worlds[i]);
+			target.draw(*m_drawables[i], node_states);
+		}
+	}
+
+	uint32_t scene_graph::get_slot(node_id id) const
+	{
+		if (id >= m_slots.size() || m_slots[id] == null_slot)
+			throw std::runtime_error{ "SCENE_GRAPH::GET_SLOT INVALID NODE!" };
+
+		return m_slots[id];
+	}
+
+	void scene_graph::sort_nodes(const std::vector<uint8_t>& removed)
+	{
+		size_t size = m_ids.size();
+
+		//Children of every slot as ranges of one array
+		std::vector<uint32_t> first_child(size + 1, 0);
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (!removed[i] && m_parents[i] != null_slot)
+				++first_child[m_parents[i] + 1];
+		}
+
+		for (size_t i = 0; i < size; ++i)
+			first_child[i + 1] += first_child[i];
+
+		std::vector<uint32_t> children(first_child[size]);
+		std::vector<uint32_t> next_child(first_child.begin(), first_child.end() - 1);
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (!removed[i] && m_parents[i] != null_slot)
+				children[next_child[m_parents[i]]++] = static_cast<uint32_t>(i);
+		}
+
+		std::vector<uint32_t> order;
+		order.reserve(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (!removed[i] && m_parents[i] == null_slot)
+				order.push_back(static_cast<uint32_t>(i));
+		}
+
+		for (size_t head = 0; head < order.size(); ++head)
+		{
+			uint32_t slot = order[head];
+			order.insert(order.end(), children.begin() + first_child[slot], children.begin() + first_child[slot + 1]);
+		}
+
+		std::vector<uint32_t> new_slots(size, null_slot);
+		for (size_t i = 0; i < order.size(); ++i)
+			new_slots[order[i]] = static_cast<uint32_t>(i);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (removed[i])
+			{
+				m_slots[m_ids[i]] = null_slot;
+				m_free_ids.push_back(m_ids[i]);
+			}
+		}
+
+		auto permute = [&order](auto& values)
+		{
+			std::remove_reference_t<decltype(values)> result;
+			result.reserve(order.size());
+
+			for (auto slot : order)
+				result.push_back(std::move(values[slot]));
+
+			values = std::move(result);
+		};
+
+		permute(m_ids);
+		permute(m_parents);
+		permute(m_locals);
+		permute(m_drawables);
+		permute(m_worlds);
+		permute(m_dirty);
+		permute(m_changed);
+
+		for (size_t i = 0; i < m_ids.size(); ++i)
+		{
+			m_slots[m_ids[i]] = static_cast<uint32_t>(i);
+
+			if (m_parents[i] != null_slot)
+				m_parents[i] = new_slots[m_parents[i]];
+		}
+	}
+
+	void scene_graph::ensure_world_transforms_are_updated() const
+	{
+		if (!m_world_transforms_need_update)
+			return;
+
+		//Parents come first, so their world transform is final when their children are reached
+		for (size_t i = 0; i < m_ids.size(); ++i)
+		{
+			uint32_t parent = m_parents[i];
+			bool changed = m_dirty[i] || (parent != null_slot && m_changed[parent]);
+
+			m_changed[i] = changed;
+			if (!changed)
+				continue;
+
+			const glm::mat4& local = m_locals[i].get_transform();
+			m_worlds[i] = parent == null_slot ? local : m_worlds[parent] * local;
+			m_dirty[i] = 0;
+		}
+
+		m_world_transforms_need_update = false;
+	}
+}
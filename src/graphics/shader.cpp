@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <SDL3/SDL.h>
 
+#include "graphics/program_binary_cache.h"
 #include "utility/gl_check.h"
 
 namespace age
@@ -21,7 +22,19 @@ namespace age
 
 	void shader::compile(std::string_view shader_source)
 	{
-		const GLchar* data = shader_source.data();
+		m_source = shader_source;
+		m_compiled = false;
+
+		if (!program_binary_cache::is_enabled())
+			compile_source();
+	}
+
+	void shader::compile_source() const
+	{
+		if (m_compiled)
+			return;
+
+		const GLchar* data = m_source.data();
 
 		GL_CALL(glShaderSource(m_handle, 1, &data, NULL));
 		GL_CALL(glCompileShader(m_handle));
@@ -47,6 +60,8 @@ namespace age
 			GL_CALL(glGetShaderInfoLog(m_handle, logSize, NULL, infoLog));
 			SDL_Log(infoLog);
 		}
+
+		m_compiled = true;
 	}
 
 	uint32_t shader::convert_type(shader_type type_to_convert)
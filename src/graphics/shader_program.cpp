@@ -6,11 +6,63 @@
 #include <string>
 #include <array>
 #include <algorithm>
-
+#include <cassert>
+#include <cstring>
+
+#include "graphics/render_stats.h"
+#include "graphics/render_target.h"
+#include "graphics/gl_state.h"
+#include "graphics/program_binary_cache.h"
+#include "engine.h"
 #include "utility/gl_check.h"
 
 namespace age
 {
+	namespace
+	{
+		template <typename T>
+		struct uniform_type;
+
+		template <> struct uniform_type<float> { static constexpr GLenum value = GL_FLOAT; };
+		template <> struct uniform_type<glm::vec2> { static constexpr GLenum value = GL_FLOAT_VEC2; };
+		template <> struct uniform_type<glm::vec3> { static constexpr GLenum value = GL_FLOAT_VEC3; };
+		template <> struct uniform_type<glm::vec4> { static constexpr GLenum value = GL_FLOAT_VEC4; };
+		template <> struct uniform_type<int32_t> { static constexpr GLenum value = GL_INT; };
+		template <> struct uniform_type<glm::ivec2> { static constexpr GLenum value = GL_INT_VEC2; };
+		template <> struct uniform_type<glm::ivec3> { static constexpr GLenum value = GL_INT_VEC3; };
+		template <> struct uniform_type<glm::ivec4> { static constexpr GLenum value = GL_INT_VEC4; };
+		template <> struct uniform_type<uint32_t> { static constexpr GLenum value = GL_UNSIGNED_INT; };
+		template <> struct uniform_type<glm::uvec2> { static constexpr GLenum value = GL_UNSIGNED_INT_VEC2; };
+		template <> struct uniform_type<glm::uvec3> { static constexpr GLenum value = GL_UNSIGNED_INT_VEC3; };
+		template <> struct uniform_type<glm::uvec4> { static constexpr GLenum value = GL_UNSIGNED_INT_VEC4; };
+		template <> struct uniform_type<glm::mat3> { static constexpr GLenum value = GL_FLOAT_MAT3; };
+		template <> struct uniform_type<glm::mat4> { static constexpr GLenum value = GL_FLOAT_MAT4; };
+
+		bool is_sampler(GLenum type)
+		{
+			switch (type)
+			{
+			case GL_SAMPLER_1D:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_3D:
+			case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_SHADOW:
+			case GL_SAMPLER_1D_ARRAY:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_2D_ARRAY_SHADOW:
+			case GL_SAMPLER_2D_MULTISAMPLE:
+			case GL_SAMPLER_BUFFER:
+			case GL_INT_SAMPLER_2D:
+			case GL_INT_SAMPLER_2D_ARRAY:
+			case GL_UNSIGNED_INT_SAMPLER_2D:
+			case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+				return true;
+			default:
+				return false;
+			}
+		}
+	}
+
 	shader_program::shader_program()
 		: m_handle{ GL_CALL(glCreateProgram()) }
 	{
@@ -26,34 +78,71 @@ namespace age
 	{
 		GL_CALL(glAttachShader(get_handle(), shader.get_handle()));
 
-		if(std::find(m_attached_shaders.begin(), m_attached_shaders.end(), shader.get_handle()) == m_attached_shaders.end())
-			m_attached_shaders.push_back(shader.get_handle());
+		if(std::find(m_attached_shaders.begin(), m_attached_shaders.end(), &shader) == m_attached_shaders.end())
+			m_attached_shaders.push_back(&shader);
 	}
 
 	void shader_program::detach_shader(const shader& shader)
 	{
 		GL_CALL(glDetachShader(get_handle(), shader.get_handle()));
 
-		if (auto it = std::find(m_attached_shaders.begin(), m_attached_shaders.end(), shader.get_handle()); it != m_attached_shaders.end())
+		if (auto it = std::find(m_attached_shaders.begin(), m_attached_shaders.end(), &shader); it != m_attached_shaders.end())
 			m_attached_shaders.erase(it);
 	}
 
 	void shader_program::bind_attrib_location(uint32_t index, std::string_view name)
 	{
-		GL_CALL(glBindAttribLocation(get_handle(), index, name.data()));
+		GL_CALL(glBindAttribLocation(get_handle(), index, std::string{ name }.c_str()));
+
+		m_attrib_locations += std::to_string(index);
+		m_attrib_locations += ' ';
+		m_attrib_locations += name;
+		m_attrib_locations += '\n';
 	}
 
 	void shader_program::link()
 	{
-		GL_CALL(glLinkProgram(get_handle()));
+		render_target::flush_pending_draws(*this);
+
+		std::string cache_description;
+		bool linked_from_cache = false;
+
+		if (program_binary_cache::is_enabled())
+		{
+			cache_description = get_cache_description();
+			linked_from_cache = program_binary_cache::load(get_handle(), cache_description);
+
+			if (!linked_from_cache)
+				GL_CALL(glProgramParameteri(get_handle(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+		}
+
+		if (!linked_from_cache)
+		{
+			try
+			{
+				//While the cache is enabled the shaders are compiled only now that they are needed
+				for (auto attached : m_attached_shaders)
+					attached->compile_source();
+			}
+			catch (...)
+			{
+				for (auto attached : m_attached_shaders)
+					GL_CALL(glDetachShader(get_handle(), attached->get_handle()));
+
+				m_attached_shaders.clear();
+				throw;
+			}
+
+			GL_CALL(glLinkProgram(get_handle()));
+		}
 
 		GLint success;
 		GL_CALL(glGetProgramiv(get_handle(), GL_LINK_STATUS, &success));
 
 		//Before potential throw, detach the shaders as it according to Khronos 
 		//it is recommended to detach them after successful or failed linking
-		for(auto handle : m_attached_shaders)
-			GL_CALL(glDetachShader(get_handle(), handle));
+		for(auto attached : m_attached_shaders)
+			GL_CALL(glDetachShader(get_handle(), attached->get_handle()));
 
 		m_attached_shaders.clear();
 
@@ -66,226 +155,320 @@ namespace age
 
 			throw std::runtime_error{ std::string{ "ERROR::SHADER_PROGRAM::LINKING_FAILED\n" } + info_log };
 		}
+
+		if (!cache_description.empty() && !linked_from_cache)
+			program_binary_cache::store(get_handle(), cache_description);
+
+		reflect();
 	}
 
 	void shader_program::bind() const
 	{
-		auto handle = get_handle();
+		if (gl_state::get_current().use_program(get_handle()))
+			++render_stats::get_current().program_binds;
+
+		if (m_deferred_uniforms_dirty)
+			apply_deferred_uniforms();
+	}
+
+	void shader_program::set_uniform_block_data(uint32_t binding, const void* data, size_t size)
+	{
+		auto it = std::find_if(m_uniform_block_data.begin(), m_uniform_block_data.end(),
+			[binding](const uniform_block_data& block) { return block.binding == binding; });
 
-		if (m_current_bound_program != handle)
+		if (it == m_uniform_block_data.end())
 		{
-			GL_CALL(glUseProgram(handle));
+			m_uniform_block_data.emplace_back();
+			it = std::prev(m_uniform_block_data.end());
+			it->binding = binding;
+		}
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		it->data.assign(bytes, bytes + size);
+		it->dirty = true;
+	}
+
+	void shader_program::clear_uniform_block_data()
+	{
+		m_uniform_block_data.clear();
+	}
 
-			m_current_bound_program = handle;
+	bool shader_program::has_uniform_block_data() const
+	{
+		return !m_uniform_block_data.empty();
+	}
+
+	void shader_program::apply_uniform_block_data() const
+	{
+		if (m_uniform_block_data.empty())
+			return;
+
+		auto engine = engine::get_instance();
+		auto& ring = engine->get_uniform_stream_buffer_object();
+
+		for (auto& block : m_uniform_block_data)
+		{
+			if (block.dirty || block.generation != ring.get_stream_generation())
+			{
+				block.offset = ring.stream_data(block.data.data(), block.data.size(), engine->get_uniform_buffer_offset_alignment());
+				//Read after streaming, which may have moved the ring on to the region the block now lies in
+				block.generation = ring.get_stream_generation();
+				block.dirty = false;
+			}
+
+			//Other programs may use the same binding, gl_state elides the call if the range is still bound
+			ring.bind_range(block.binding, block.offset, block.data.size());
 		}
 	}
 
 	void shader_program::release()
 	{
-		GL_CALL(glUseProgram(0));
+		gl_state::get_current().use_program(0);
 	}
 
 	int32_t shader_program::get_uniform_location(std::string_view name) const
 	{
-		return GL_CALL(glGetUniformLocation(get_handle(), name.data()));
+		if (auto uniform = m_uniforms.find(name))
+			return uniform->location;
+
+		//Only the first element of an array is reflected, the driver knows the others
+		if (!name.empty() && name.back() == ']')
+			return GL_CALL(glGetUniformLocation(get_handle(), std::string{ name }.c_str()));
+
+		return -1;
 	}
 
 	uint32_t shader_program::get_uniform_block_index(std::string_view name) const
 	{
-		GLuint ubo_index = GL_CALL(glGetUniformBlockIndex(get_handle(), name.data()));
-		return ubo_index;
+		if (auto block = m_uniform_blocks.find(name))
+			return block->index;
+
+		return GL_INVALID_INDEX;
+	}
+
+	const shader_program::uniform_info* shader_program::find_uniform(std::string_view name) const
+	{
+		return m_uniforms.find(name);
 	}
 
+	const shader_program::uniform_block_info* shader_program::find_uniform_block(std::string_view name) const
+	{
+		return m_uniform_blocks.find(name);
+	}
+
+	template <typename T>
+	uniform_handle<T> shader_program::get_uniform_handle(std::string_view name) const
+	{
+		return uniform_handle<T>{ add_deferred_uniform(name, uniform_type<T>::value, sizeof(T)) };
+	}
+
+	template uniform_handle<float> shader_program::get_uniform_handle<float>(std::string_view name) const;
+	template uniform_handle<glm::vec2> shader_program::get_uniform_handle<glm::vec2>(std::string_view name) const;
+	template uniform_handle<glm::vec3> shader_program::get_uniform_handle<glm::vec3>(std::string_view name) const;
+	template uniform_handle<glm::vec4> shader_program::get_uniform_handle<glm::vec4>(std::string_view name) const;
+	template uniform_handle<int32_t> shader_program::get_uniform_handle<int32_t>(std::string_view name) const;
+	template uniform_handle<glm::ivec2> shader_program::get_uniform_handle<glm::ivec2>(std::string_view name) const;
+	template uniform_handle<glm::ivec3> shader_program::get_uniform_handle<glm::ivec3>(std::string_view name) const;
+	template uniform_handle<glm::ivec4> shader_program::get_uniform_handle<glm::ivec4>(std::string_view name) const;
+	template uniform_handle<uint32_t> shader_program::get_uniform_handle<uint32_t>(std::string_view name) const;
+	template uniform_handle<glm::uvec2> shader_program::get_uniform_handle<glm::uvec2>(std::string_view name) const;
+	template uniform_handle<glm::uvec3> shader_program::get_uniform_handle<glm::uvec3>(std::string_view name) const;
+	template uniform_handle<glm::uvec4> shader_program::get_uniform_handle<glm::uvec4>(std::string_view name) const;
+	template uniform_handle<glm::mat3> shader_program::get_uniform_handle<glm::mat3>(std::string_view name) const;
+	template uniform_handle<glm::mat4> shader_program::get_uniform_handle<glm::mat4>(std::string_view name) const;
+
 	void shader_program::set_uniform_block_binding(uint32_t index, uint32_t binding)
 	{
+		render_target::flush_pending_draws(*this);
+
 		GL_CALL(glUniformBlockBinding(get_handle(), index, binding));
 	}
 
 	void shader_program::set_uniform_block_binding(std::string_view name, uint32_t binding)
 	{
-		GL_CALL(glUniformBlockBinding(get_handle(), get_uniform_block_index(name), binding));
+		set_uniform_block_binding(get_uniform_block_index(name), binding);
 	}
 
 	void shader_program::set_uniform(int32_t location, float v0) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform1f(location, v0));
+		GL_CALL(glProgramUniform1f(get_handle(), location, v0));
 	}
 
 	void shader_program::set_uniform(int32_t location, float v0, float v1) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform2f(location, v0, v1));
+		GL_CALL(glProgramUniform2f(get_handle(), location, v0, v1));
 	}
 
 	void shader_program::set_uniform(int32_t location, float v0, float v1, float v2) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform3f(location, v0, v1, v2));
+		GL_CALL(glProgramUniform3f(get_handle(), location, v0, v1, v2));
 	}
 
 	void shader_program::set_uniform(int32_t location, float v0, float v1, float v2, float v3) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform4f(location, v0, v1, v2, v3));
+		GL_CALL(glProgramUniform4f(get_handle(), location, v0, v1, v2, v3));
 	}
 
 	void shader_program::set_uniform(int32_t location, int32_t v0) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform1i(location, v0));
+		GL_CALL(glProgramUniform1i(get_handle(), location, v0));
 	}
 
 	void shader_program::set_uniform(int32_t location, int32_t v0, int32_t v1) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform2i(location, v0, v1));
+		GL_CALL(glProgramUniform2i(get_handle(), location, v0, v1));
 	}
 
 	void shader_program::set_uniform(int32_t location, int32_t v0, int32_t v1, int32_t v2) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform3i(location, v0, v1, v2));
+		GL_CALL(glProgramUniform3i(get_handle(), location, v0, v1, v2));
 	}
 
 	void shader_program::set_uniform(int32_t location, int32_t v0, int32_t v1, int32_t v2, int32_t v3) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform4i(location, v0, v1, v2, v3));
+		GL_CALL(glProgramUniform4i(get_handle(), location, v0, v1, v2, v3));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t v0) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform1ui(location, v0));
+		GL_CALL(glProgramUniform1ui(get_handle(), location, v0));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t v0, uint32_t v1) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform2ui(location, v0, v1));
+		GL_CALL(glProgramUniform2ui(get_handle(), location, v0, v1));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t v0, uint32_t v1, uint32_t v2) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform3ui(location, v0, v1, v2));
+		GL_CALL(glProgramUniform3ui(get_handle(), location, v0, v1, v2));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform4ui(location, v0, v1, v2, v3));
+		GL_CALL(glProgramUniform4ui(get_handle(), location, v0, v1, v2, v3));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<float, 1>& v) const
 	{
-		bind();
-		
-		GL_CALL(glUniform1fv(location, count, v.data()));
+		render_target::flush_pending_draws(*this);
+
+		GL_CALL(glProgramUniform1fv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<float, 2>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform2fv(location, count, v.data()));
+		GL_CALL(glProgramUniform2fv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<float, 3>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform3fv(location, count, v.data()));
+		GL_CALL(glProgramUniform3fv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<float, 4>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform4fv(location, count, v.data()));
+		GL_CALL(glProgramUniform4fv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<int32_t, 1>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform1iv(location, count, v.data()));
+		GL_CALL(glProgramUniform1iv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<int32_t, 2>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform2iv(location, count, v.data()));
+		GL_CALL(glProgramUniform2iv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<int32_t, 3>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform3iv(location, count, v.data()));
+		GL_CALL(glProgramUniform3iv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<int32_t, 4>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform4iv(location, count, v.data()));
+		GL_CALL(glProgramUniform4iv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<uint32_t, 1>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform1uiv(location, count, v.data()));
+		GL_CALL(glProgramUniform1uiv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<uint32_t, 2>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform2uiv(location, count, v.data()));
+		GL_CALL(glProgramUniform2uiv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<uint32_t, 3>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform3uiv(location, count, v.data()));
+		GL_CALL(glProgramUniform3uiv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, uint32_t count, const std::array<uint32_t, 4>& v) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniform4uiv(location, count, v.data()));
+		GL_CALL(glProgramUniform4uiv(get_handle(), location, count, v.data()));
 	}
 
 	void shader_program::set_uniform(int32_t location, const glm::mat4& v, bool transpose) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniformMatrix4fv(location, 1, transpose ? GL_TRUE : GL_FALSE, reinterpret_cast<const float*>(&v)));
+		GL_CALL(glProgramUniformMatrix4fv(get_handle(), location, 1, transpose ? GL_TRUE : GL_FALSE, reinterpret_cast<const float*>(&v)));
 	}
 
 	void shader_program::set_uniform(int32_t location, const glm::mat4* v[], size_t size, bool transpose) const
 	{
-		bind();
+		render_target::flush_pending_draws(*this);
 
-		GL_CALL(glUniformMatrix4fv(location, static_cast<GLsizei>(size), transpose, reinterpret_cast<float*>(v)));
+		GL_CALL(glProgramUniformMatrix4fv(get_handle(), location, static_cast<GLsizei>(size), transpose, reinterpret_cast<float*>(v)));
 	}
 
 	void shader_program::set_uniform(std::string_view name, float v0) const
@@ -470,8 +653,180 @@ namespace age
 		set_uniform(loc, v, size, transpose);
 	}
 
+	std::string shader_program::get_cache_description() const
+	{
+		std::string result = m_attrib_locations;
+
+		//The sizes keep the sources apart, whatever they contain
+		for (auto attached : m_attached_shaders)
+		{
+			const auto& source = attached->get_source();
+
+			result += std::to_string(static_cast<int>(attached->get_type()));
+			result += ' ';
+			result += std::to_string(source.size());
+			result += '\n';
+			result += source;
+		}
+
+		return result;
+	}
+
+	void shader_program::reflect()
+	{
+		m_uniforms.clear();
+		m_uniform_blocks.clear();
+
+		//Handles of the previous link point to locations which may not exist anymore
+		m_deferred_uniforms.clear();
+		m_deferred_values.clear();
+		m_deferred_uniforms_dirty = false;
+
+		GLint max_name_length = 0;
+		GL_CALL(glGetProgramInterfaceiv(get_handle(), GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length));
+		GLint block_max_name_length = 0;
+		GL_CALL(glGetProgramInterfaceiv(get_handle(), GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &block_max_name_length));
+
+		std::string name(static_cast<size_t>(std::max({ max_name_length, block_max_name_length, 1 })), '\0');
+
+		GLint num_uniforms = 0;
+		GL_CALL(glGetProgramInterfaceiv(get_handle(), GL_UNIFORM, GL_ACTIVE_RESOURCES, &num_uniforms));
+
+		for (GLint i = 0; i < num_uniforms; ++i)
+		{
+			static constexpr std::array<GLenum, 3> properties{ GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE };
+			std::array<GLint, 3> values{};
+
+			GL_CALL(glGetProgramResourceiv(get_handle(), GL_UNIFORM, static_cast<GLuint>(i),
+				static_cast<GLsizei>(properties.size()), properties.data(), static_cast<GLsizei>(values.size()), nullptr, values.data()));
+
+			//Members of uniform blocks have no location
+			if (values[0] < 0)
+				continue;
+
+			GLsizei length = 0;
+			GL_CALL(glGetProgramResourceName(get_handle(), GL_UNIFORM, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, name.data()));
+
+			std::string_view uniform_name{ name.data(), static_cast<size_t>(length) };
+			uniform_info info{ values[0], static_cast<uint32_t>(values[1]), values[2] };
+
+			m_uniforms.insert(uniform_name, info);
+
+			//Arrays are reported as name[0], but may be looked up without the index like with glGetUniformLocation
+			constexpr std::string_view first_element{ "[0]" };
+			if (uniform_name.size() > first_element.size() && uniform_name.substr(uniform_name.size() - first_element.size()) == first_element)
+				m_uniforms.insert(uniform_name.substr(0, uniform_name.size() - first_element.size()), info);
+		}
+
+		GLint num_blocks = 0;
+		GL_CALL(glGetProgramInterfaceiv(get_handle(), GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &num_blocks));
+
+		for (GLint i = 0; i < num_blocks; ++i)
+		{
+			static constexpr GLenum property = GL_BUFFER_DATA_SIZE;
+			GLint data_size = 0;
+
+			GL_CALL(glGetProgramResourceiv(get_handle(), GL_UNIFORM_BLOCK, static_cast<GLuint>(i), 1, &property, 1, nullptr, &data_size));
+
+			GLsizei length = 0;
+			GL_CALL(glGetProgramResourceName(get_handle(), GL_UNIFORM_BLOCK, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, name.data()));
+
+			m_uniform_blocks.insert(std::string_view{ name.data(), static_cast<size_t>(length) }, uniform_block_info{ static_cast<uint32_t>(i), static_cast<uint32_t>(data_size) });
+		}
+	}
+
+	uint32_t shader_program::add_deferred_uniform(std::string_view name, uint32_t type, size_t size) const
+	{
+		auto uniform = m_uniforms.find(name);
+		if (!uniform)
+			return uniform_handle<float>::invalid_index;
+
+		//Samplers are set with an int like with glUniform1i
+		bool matches = uniform->type == type || (type == GL_INT && is_sampler(uniform->type));
+		if (!matches)
+			throw std::runtime_error{ "SHADER_PROGRAM::GET_UNIFORM_HANDLE TYPE MISMATCH OF " + std::string{ name } + "!" };
+
+		//Handles of the same uniform share the value
+		auto it = std::find_if(m_deferred_uniforms.begin(), m_deferred_uniforms.end(),
+			[uniform](const deferred_uniform& deferred) { return deferred.location == uniform->location; });
+
+		if (it != m_deferred_uniforms.end())
+			return static_cast<uint32_t>(std::distance(m_deferred_uniforms.begin(), it));
+
+		deferred_uniform deferred;
+		deferred.location = uniform->location;
+		deferred.type = uniform->type;
+		deferred.offset = static_cast<uint32_t>(m_deferred_values.size());
+		deferred.size = static_cast<uint32_t>(size);
+
+		m_deferred_values.resize(m_deferred_values.size() + size);
+		m_deferred_uniforms.push_back(deferred);
+
+		return static_cast<uint32_t>(m_deferred_uniforms.size() - 1);
+	}
+
+	void shader_program::set_deferred_uniform(uint32_t index, const void* value, size_t size) const
+	{
+		assert(index < m_deferred_uniforms.size());
+
+		auto& deferred = m_deferred_uniforms[index];
+		assert(deferred.size == size);
+
+		uint8_t* stored = m_deferred_values.data() + deferred.offset;
+
+		//Setting the same value every frame costs nothing at bind time
+		if (deferred.has_value && std::memcmp(stored, value, size) == 0)
+			return;
+
+		//Draws which are still batched have to be submitted with the previous value
+		render_target::flush_pending_draws(*this);
+
+		std::memcpy(stored, value, size);
+		deferred.has_value = true;
+		deferred.dirty = true;
+		m_deferred_uniforms_dirty = true;
+	}
+
+	void shader_program::apply_deferred_uniforms() const
+	{
+		for (auto& deferred : m_deferred_uniforms)
+		{
+			if (!deferred.dirty)
+				continue;
+
+			const void* value = m_deferred_values.data() + deferred.offset;
+			const auto* floats = static_cast<const GLfloat*>(value);
+			const auto* ints = static_cast<const GLint*>(value);
+			const auto* uints = static_cast<const GLuint*>(value);
+
+			switch (deferred.type)
+			{
+			case GL_FLOAT: GL_CALL(glUniform1fv(deferred.location, 1, floats)); break;
+			case GL_FLOAT_VEC2: GL_CALL(glUniform2fv(deferred.location, 1, floats)); break;
+			case GL_FLOAT_VEC3: GL_CALL(glUniform3fv(deferred.location, 1, floats)); break;
+			case GL_FLOAT_VEC4: GL_CALL(glUniform4fv(deferred.location, 1, floats)); break;
+			case GL_INT_VEC2: GL_CALL(glUniform2iv(deferred.location, 1, ints)); break;
+			case GL_INT_VEC3: GL_CALL(glUniform3iv(deferred.location, 1, ints)); break;
+			case GL_INT_VEC4: GL_CALL(glUniform4iv(deferred.location, 1, ints)); break;
+			case GL_UNSIGNED_INT: GL_CALL(glUniform1uiv(deferred.location, 1, uints)); break;
+			case GL_UNSIGNED_INT_VEC2: GL_CALL(glUniform2uiv(deferred.location, 1, uints)); break;
+			case GL_UNSIGNED_INT_VEC3: GL_CALL(glUniform3uiv(deferred.location, 1, uints)); break;
+			case GL_UNSIGNED_INT_VEC4: GL_CALL(glUniform4uiv(deferred.location, 1, uints)); break;
+			case GL_FLOAT_MAT3: GL_CALL(glUniformMatrix3fv(deferred.location, 1, GL_FALSE, floats)); break;
+			case GL_FLOAT_MAT4: GL_CALL(glUniformMatrix4fv(deferred.location, 1, GL_FALSE, floats)); break;
+			//GL_INT and the samplers
+			default: GL_CALL(glUniform1iv(deferred.location, 1, ints)); break;
+			}
+
+			deferred.dirty = false;
+		}
+
+		m_deferred_uniforms_dirty = false;
+	}
+
 	void shader_program::delete_handle(uint32_t handle)
 	{
+		gl_state::get_current().forget_program(handle);
 		GL_CALL(glDeleteProgram(handle));
 	}
 }
\ No newline at end of file
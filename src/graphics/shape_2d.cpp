@@ -0,0 +1,45 @@
+#include "graphics/shape_2d.h"
+
+#include <limits>
+
+#include <glm/common.hpp>
+
+#include "graphics/vertex_2d.h"
+
+namespace age
+{
+	float_rect shape_2d::get_local_bounds() const
+	{
+		glm::vec2 min{ std::numeric_limits<float>::max() };
+		glm::vec2 max{ std::numeric_limits<float>::lowest() };
+
+		for (const auto& data : { get_vertex_data(), get_outline_vertex_data() })
+		{
+			for (size_t i = 0; i < data.num_vertices; ++i)
+			{
+				min = glm::min(min, data.vertices[i].position);
+				max = glm::max(max, data.vertices[i].position);
+			}
+		}
+
+		if (min.x > max.x)
+			return float_rect{};
+
+		return float_rect{ min, max - min };
+	}
+
+	float_rect shape_2d::get_global_bounds() const
+	{
+		return transform_rect(get_transform(), get_local_bounds());
+	}
+
+	shape_2d::vertex_data shape_2d::on_get_outline_vertex_data() const
+	{
+		return vertex_data{ nullptr, 0, nullptr, 0 };
+	}
+
+	std::optional<float_rect> shape_2d::get_cull_bounds() const
+	{
+		return get_global_bounds();
+	}
+}
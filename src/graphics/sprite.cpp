@@ -1,6 +1,8 @@
 #include "graphics/sprite.h"
 
 #include "graphics/render_states.h"
+#include "graphics/texture_array.h"
+#include "graphics/vertex_kernels.h"
 #include "engine.h"
 
 namespace age
@@ -21,7 +23,8 @@ namespace age
 	{
 		if (value != m_vertices[0].color)
 		{
-			for (auto& v : m_vertices) v.color = value;
+			set_colors(m_vertices.data(), m_vertices.size(), value);
+			m_mesh.invalidate();
 		}
 	}
 
@@ -30,10 +33,13 @@ namespace age
 		return m_vertices[0].color;
 	}
 
-	void sprite::set_texture(const texture& value)
+	void sprite::set_texture(const texture& value, bool reset_texture_rect)
 	{
 		m_texture = &value;
 
+		if (reset_texture_rect)
+			m_texture_rect = uint_rect{};
+
 		update_vertices();
 	}
 
@@ -42,26 +48,124 @@ namespace age
 		return *m_texture;
 	}
 
+	void sprite::set_texture_rect(const uint_rect& value)
+	{
+		if (m_texture_rect != value)
+		{
+			m_texture_rect = value;
+			update_vertices();
+		}
+	}
+
+	void sprite::set_texture_rect(const atlas_region& value)
+	{
+		if (!value.is_valid())
+			return;
+
+		m_texture = value.page;
+		m_texture_rect = value.rect;
+
+		update_vertices();
+	}
+
+	const uint_rect& sprite::get_texture_rect() const
+	{
+		return m_texture_rect;
+	}
+
+	void sprite::set_texture_layer(uint32_t value)
+	{
+		if (m_texture_layer != value)
+		{
+			m_texture_layer = value;
+			update_vertices();
+		}
+	}
+
+	uint32_t sprite::get_texture_layer() const
+	{
+		return m_texture_layer;
+	}
+
+	float_rect sprite::get_local_bounds() const
+	{
+		return float_rect{ glm::vec2{ 0.0f, 0.0f }, m_vertices[2].position };
+	}
+
+	float_rect sprite::get_global_bounds() const
+	{
+		return transform_rect(get_transform(), get_local_bounds());
+	}
+
+	void sprite::set_retained(bool value)
+	{
+		if (m_retained == value)
+			return;
+
+		m_retained = value;
+
+		if (!m_retained)
+			m_mesh.reset();
+	}
+
+	bool sprite::is_retained() const
+	{
+		return m_retained;
+	}
+
 	void sprite::draw(render_target& target, const render_states& states) const
 	{
 		render_states states_copy = states;
 
 		states_copy.set_texture(*m_texture);
 		states_copy.get_transform() *= get_transform();
+		states_copy.set_batching(true);
+
+		//All layers of an array share the program and texture, so sprites of different layers still batch
+		auto* e = engine::get_instance();
+		if (m_texture->is_array() && &states_copy.get_shader_program() == &e->get_default_shader_program())
+			states_copy.set_shader_program(e->get_texture_array_shader_program());
+
+		if (m_retained)
+		{
+			target.draw(m_mesh.update(m_vertices.data(), m_vertices.size(), age::primitive_type::triangle_fan), states_copy);
+			return;
+		}
 
 		target.draw(m_vertices.data(), m_vertices.size(), age::primitive_type::triangle_fan, states_copy);
 	}
 
+	std::optional<float_rect> sprite::get_cull_bounds() const
+	{
+		return get_global_bounds();
+	}
+
 	void sprite::update_vertices()
 	{
-		auto& tex_size = m_texture->get_size();
-		glm::vec2 size{ static_cast<float>(tex_size.x), static_cast<float>(tex_size.y) };
+		uint_rect rect = m_texture_rect;
+		if (rect.width == 0 || rect.height == 0)
+			rect = uint_rect{ glm::u32vec2{ 0, 0 }, m_texture->get_size() };
+
+		glm::vec2 size{ static_cast<float>(rect.width), static_cast<float>(rect.height) };
+		glm::vec2 tex_begin{ static_cast<float>(rect.left), static_cast<float>(rect.top) };
+		glm::vec2 tex_end = tex_begin + size;
+
+		if (m_texture->is_array())
+		{
+			float layer_offset = static_cast<const texture_array*>(m_texture)->get_layer_offset(m_texture_layer);
+			tex_begin.y += layer_offset;
+			tex_end.y += layer_offset;
+		}
 
-		m_vertices[1].position.x = size.x;
-		m_vertices[1].tex_coords.x = size.x;
+		m_vertices[0].position = glm::vec2{ 0.0f, 0.0f };
+		m_vertices[0].tex_coords = tex_begin;
+		m_vertices[1].position = glm::vec2{ size.x, 0.0f };
+		m_vertices[1].tex_coords = glm::vec2{ tex_end.x, tex_begin.y };
 		m_vertices[2].position = size;
-		m_vertices[2].tex_coords = size;
-		m_vertices[3].position.y = size.y;
-		m_vertices[3].tex_coords.y = size.y;
+		m_vertices[2].tex_coords = tex_end;
+		m_vertices[3].position = glm::vec2{ 0.0f, size.y };
+		m_vertices[3].tex_coords = glm::vec2{ tex_begin.x, tex_end.y };
+
+		m_mesh.invalidate();
 	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <algorithm>
 
 #include "graphics/render_states.h"
+#include "graphics/vertex_kernels.h"
 
 void add_line(std::vector<age::vertex_2d>& vertices,
 	float line_length,
@@ -190,8 +191,9 @@ namespace age
 
 			if (!m_geometry_needs_update)
 			{
-				for (auto& v : m_vertices)
-					v.color = m_fill_color;
+				set_colors(m_vertices.data(), m_vertices.size(), m_fill_color);
+
+				m_mesh.invalidate();
 			}
 		}
 	}
@@ -209,8 +211,9 @@ namespace age
 
 			if (!m_geometry_needs_update)
 			{
-				for (auto& v : m_outline_vertices)
-					v.color = m_outline_color;
+				set_colors(m_outline_vertices.data(), m_outline_vertices.size(), m_outline_color);
+
+				m_outline_mesh.invalidate();
 			}
 		}
 	}
@@ -294,6 +297,30 @@ namespace age
 		return local_bounds;
 	}
 
+	std::optional<float_rect> text::get_cull_bounds() const
+	{
+		return transform_rect(get_transform(), get_local_bounds());
+	}
+
+	void text::set_retained(bool value)
+	{
+		if (m_retained == value)
+			return;
+
+		m_retained = value;
+
+		if (!m_retained)
+		{
+			m_mesh.reset();
+			m_outline_mesh.reset();
+		}
+	}
+
+	bool text::is_retained() const
+	{
+		return m_retained;
+	}
+
 	void text::draw(render_target& target, const render_states& states) const
 	{
 		if (m_font)
@@ -303,6 +330,18 @@ namespace age
 			render_states states_copy = states;
 			states_copy.get_transform() *= get_transform();
 			states_copy.set_texture(m_font->get_texture(m_character_size));
+			states_copy.set_batching(true);
+
+			if (m_retained)
+			{
+				if (m_outline_thickness != 0.0f && !m_outline_vertices.empty())
+					target.draw(m_outline_mesh.update(m_outline_vertices.data(), m_outline_vertices.size(), primitive_type::triangles), states_copy);
+
+				if (!m_vertices.empty())
+					target.draw(m_mesh.update(m_vertices.data(), m_vertices.size(), primitive_type::triangles), states_copy);
+
+				return;
+			}
 
 			if (m_outline_thickness != 0.0f)
 				target.draw(m_outline_vertices.data(), m_outline_vertices.size(), primitive_type::triangles, states_copy);
@@ -329,6 +368,9 @@ namespace age
 		m_outline_vertices.clear();
 		m_bounds = float_rect{};
 
+		m_mesh.invalidate();
+		m_outline_mesh.invalidate();
+
 		if (m_string.empty())
 			return;
 		
@@ -4,25 +4,37 @@
 #include <sstream>
 #include <cassert>
 
+#include <glm/common.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <glad/glad.h>
 
 #include "engine.h"
+#include "graphics/render_stats.h"
+#include "graphics/render_target.h"
+#include "graphics/gl_state.h"
+#include "graphics/raw_texture.h"
+#include "system/mapped_file.h"
 #include "utility/gl_check.h"
 
 namespace age
 {
 	texture::texture()
-		: m_handle{ gen_handle() }
+		: texture{ GL_TEXTURE_2D }
 	{}
 
 	texture::texture(const texture& other)
 		: m_handle{ gen_handle() }
+		, m_target{ GL_TEXTURE_2D }
 	{
 
 	}
 
+	texture::~texture()
+	{
+		render_target::flush_pending_draws(*this);
+	}
+
 	texture& texture::operator = (const texture& other)
 	{
 		return *this;
@@ -32,17 +44,8 @@ namespace age
 	{
 		auto handle = get_handle();
 
-		if (handle != m_current_bound_texture)
-		{
-			GL_CALL(glBindTexture(GL_TEXTURE_2D, handle));
-			
-			const glm::u32vec2& size = get_size();
-
-			glm::mat4 tex_matrix = glm::scale(glm::mat4{ 1.0f }, glm::vec3(1.0f / static_cast<float>(size.x), 1.0f / static_cast<float>(size.y), 1.0f));
-			age::engine::get_instance()->get_texture_matrix_ubo().buffer_data(sizeof(glm::mat4), &tex_matrix);
-			
-			m_current_bound_texture = handle;
-		}
+		if (gl_state::get_current().bind_texture(m_target, handle))
+			++render_stats::get_current().texture_binds;
 	}
 
 	void texture::create(const glm::u32vec2& size)
@@ -65,7 +68,10 @@ namespace age
 			throw std::runtime_error{ message.str() };
 		}
 
+		render_target::flush_pending_draws(*this);
+
 		m_size = size;
+		set_pixels_flipped(false);
 	
 		bind();
 
@@ -159,6 +165,45 @@ namespace age
 		}
 	}
 
+	void texture::load_raw(std::string_view filename)
+	{
+		mapped_file file{ filename };
+		load_raw(file.get_data(), file.get_size());
+	}
+
+	void texture::load_raw(const std::byte data[], std::size_t size)
+	{
+		auto levels = raw_texture::parse(data, size);
+
+		create(levels.front().size);
+		update(levels.front().pixels);
+
+		if (levels.size() == 1)
+			return;
+
+		for (size_t i = 1; i < levels.size(); ++i)
+		{
+			const auto& level = levels[i];
+
+			GL_CALL(glTexImage2D(
+				GL_TEXTURE_2D,
+				static_cast<GLint>(i),
+				GL_RGBA,
+				static_cast<GLsizei>(level.size.x),
+				static_cast<GLsizei>(level.size.y),
+				0,
+				GL_RGBA,
+				GL_UNSIGNED_BYTE,
+				level.pixels));
+		}
+
+		GL_CALL(glTexParameteri(GL_TEXTURE_2D,
+			GL_TEXTURE_MIN_FILTER,
+			m_smooth ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR));
+
+		m_has_mipmap = true;
+	}
+
 	void texture::update(const uint8_t* pixels)
 	{
 		update(pixels, uint_rect{ glm::u32vec2{}, get_size() });
@@ -171,6 +216,8 @@ namespace age
 
 		if (pixels)
 		{
+			render_target::flush_pending_draws(*this);
+
 			bind();
 
 			GL_CALL(glTexSubImage2D(GL_TEXTURE_2D,
@@ -198,10 +245,50 @@ namespace age
 
 	void texture::update(const texture& other_texture, const glm::u32vec2& dest)
 	{
-		assert(dest.x + other_texture.m_size.x <= m_size.x);
-		assert(dest.y + other_texture.m_size.y <= m_size.y);
+		update(other_texture, uint_rect{ glm::u32vec2{}, other_texture.m_size }, dest);
+	}
+
+	void texture::update(const texture& other_texture, const uint_rect& area, const glm::u32vec2& dest)
+	{
+		assert(area.left + area.width <= other_texture.m_size.x);
+		assert(area.top + area.height <= other_texture.m_size.y);
+		assert(dest.x + area.width <= m_size.x);
+		assert(dest.y + area.height <= m_size.y);
+		assert(!is_array() && !other_texture.is_array());
+
+		if (area.width == 0 || area.height == 0)
+			return;
+
+		render_target::flush_pending_draws(*this);
+
+		// Flipped textures store their rows bottom up, so the rows are located from the bottom
+		uint_rect source_area = area;
+		if (other_texture.m_pixels_flipped)
+			source_area.top = other_texture.m_size.y - area.top - area.height;
+
+		uint_rect dest_area{ dest, area.get_size() };
+		if (m_pixels_flipped)
+			dest_area.top = m_size.y - dest.y - area.height;
+
+		bool flip = other_texture.m_pixels_flipped != m_pixels_flipped;
+
+		if (!flip && GLAD_GL_VERSION_4_3)
+		{
+			GL_CALL(glCopyImageSubData(
+				other_texture.get_handle(), GL_TEXTURE_2D, 0, static_cast<GLint>(source_area.left), static_cast<GLint>(source_area.top), 0,
+				get_handle(), GL_TEXTURE_2D, 0, static_cast<GLint>(dest_area.left), static_cast<GLint>(dest_area.top), 0,
+				static_cast<GLsizei>(area.width),
+				static_cast<GLsizei>(area.height),
+				1));
+		}
+		else
+		{
+			blit(other_texture, source_area, dest_area, flip);
+		}
 
-		update(other_texture.copy_to_image(), dest);
+		bind();
+		GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+		m_has_mipmap = false;
 	}
 
 	void texture::update(const image& img)
@@ -215,15 +302,70 @@ namespace age
 		update(img.get_pixel_ptr(), uint_rect{ dest, img.get_size() });
 	}
 
-	void texture::update(const render_window& window)
+	void texture::update(render_window& window)
 	{
 		update(window, { 0, 0 });
 	}
 
-	void texture::update(const render_window& window, const glm::u32vec2& dest)
+	void texture::update(render_window& window, const glm::u32vec2& dest)
 	{
+		auto window_size = window.get_size();
+
+		if (dest.x + window_size.x > m_size.x || dest.y + window_size.y > m_size.y)
+			throw std::runtime_error{ "TEXTURE::UPDATE THE WINDOW DOES NOT FIT INTO THE TEXTURE!" };
+
+		// The rows of the framebuffer are bottom up, which only a flipped texture can take partially
+		bool covers_texture = dest == glm::u32vec2{ 0, 0 } && window_size == m_size;
+		if (!covers_texture && !m_pixels_flipped)
+			throw std::runtime_error{ "TEXTURE::UPDATE PARTIAL COPIES OF A WINDOW NEED A FLIPPED TEXTURE!" };
+
+		// Submits the draws of the window, and of the previously active target which may use this texture
+		window.activate();
+		window.flush();
+
+		// Flipped textures store their rows bottom up, so the rows are located from the bottom
+		auto dest_top = covers_texture ? 0 : m_size.y - dest.y - window_size.y;
+
 		bind();
-		//ToDo: Finish me
+
+		GLint previous_read_frame_buffer;
+		GL_CALL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_frame_buffer));
+
+		auto& state = gl_state::get_current();
+		state.bind_framebuffer(GL_READ_FRAMEBUFFER, window.get_framebuffer_id());
+		GL_CALL(glCopyTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(dest.x), static_cast<GLint>(dest_top), 0, 0, static_cast<GLsizei>(window_size.x), static_cast<GLsizei>(window_size.y)));
+		state.bind_framebuffer(GL_READ_FRAMEBUFFER, static_cast<uint32_t>(previous_read_frame_buffer));
+
+		GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+		m_has_mipmap = false;
+
+		set_pixels_flipped(true);
+	}
+
+	void texture::resize(const glm::u32vec2& size, bool preserve_contents)
+	{
+		if (is_array())
+			throw std::runtime_error{ "TEXTURE::RESIZE TEXTURE ARRAYS CAN NOT BE RESIZED!" };
+
+		if (size == m_size)
+			return;
+
+		render_target::flush_pending_draws(*this);
+
+		// Textures can't be resized in place, so the pixels are copied into new storage on the GPU
+		texture resized;
+		resized.m_smooth = m_smooth;
+		resized.m_srgb = m_srgb;
+		resized.m_repeat = m_repeat;
+		resized.create(size);
+
+		if (preserve_contents && m_size.x && m_size.y)
+			resized.update(*this, uint_rect{ glm::u32vec2{}, glm::min(m_size, size) }, glm::u32vec2{});
+
+		m_handle = std::move(resized.m_handle);
+		m_size = size;
+		m_has_mipmap = false;
+		set_pixels_flipped(false);
 	}
 
 	const glm::u32vec2& texture::get_size() const
@@ -231,6 +373,48 @@ namespace age
 		return m_size;
 	}
 
+	glm::mat4 texture::get_texture_matrix() const
+	{
+		glm::mat4 tex_matrix{ 1.0f };
+		if (m_pixels_flipped)
+			tex_matrix = glm::translate(tex_matrix, glm::vec3{ 0.0f, 1.0f, 0.0f });
+
+		return glm::scale(tex_matrix, glm::vec3(1.0f / static_cast<float>(m_size.x), (m_pixels_flipped ? -1.0f : 1.0f) / static_cast<float>(m_size.y), 1.0f));
+	}
+
+	void texture::clear(const color& value)
+	{
+		assert(!is_array());
+
+		GLuint framebuffer;
+		GL_CALL(glGenFramebuffers(1, &framebuffer));
+
+		if (!framebuffer)
+			throw std::runtime_error{ "TEXTURE::CLEAR FAILED TO CREATE A FRAMEBUFFER!" };
+
+		render_target::flush_pending_draws(*this);
+
+		GLint previous_frame_buffer;
+		GL_CALL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_frame_buffer));
+
+		auto& state = gl_state::get_current();
+		state.bind_framebuffer(GL_FRAMEBUFFER, framebuffer);
+		GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, get_handle(), 0));
+
+		GLfloat rgba[4]{ value.r / 255.0f, value.g / 255.0f, value.b / 255.0f, value.a / 255.0f };
+		GL_CALL(glClearBufferfv(GL_COLOR, 0, rgba));
+
+		state.bind_framebuffer(GL_FRAMEBUFFER, static_cast<uint32_t>(previous_frame_buffer));
+		GL_CALL(glDeleteFramebuffers(1, &framebuffer));
+
+		if (m_has_mipmap)
+		{
+			bind();
+			GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+			m_has_mipmap = false;
+		}
+	}
+
 	image texture::copy_to_image() const
 	{
 		image result{};
@@ -245,14 +429,18 @@ namespace age
 			GLint previous_frame_buffer;
 			GL_CALL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_frame_buffer));
 
-			GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+			auto& state = gl_state::get_current();
+			state.bind_framebuffer(GL_FRAMEBUFFER, framebuffer);
 			GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, get_handle(), 0));
 			GL_CALL(glReadPixels(0, 0, m_size.x, m_size.y, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]));
 
+			state.bind_framebuffer(GL_FRAMEBUFFER, static_cast<uint32_t>(previous_frame_buffer));
 			GL_CALL(glDeleteFramebuffers(1, &framebuffer));
-			GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, previous_frame_buffer));
 
 			result.create(m_size, pixels.data());
+
+			if (m_pixels_flipped)
+				result.flip_vertical();
 		}
 
 		return result;
@@ -265,16 +453,16 @@ namespace age
 			m_smooth = value;
 
 			bind();
-			GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+			GL_CALL(glTexParameteri(m_target, GL_TEXTURE_MAG_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
 			if (m_has_mipmap)
 			{
-				GL_CALL(glTexParameteri(GL_TEXTURE_2D,
+				GL_CALL(glTexParameteri(m_target,
 					GL_TEXTURE_MIN_FILTER,
 					m_smooth ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR));
 			}
 			else
 			{
-				GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+				GL_CALL(glTexParameteri(m_target, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
 			}
 		}
 	}
@@ -298,11 +486,11 @@ namespace age
 	{
 		bind();
 
-		GL_CALL(glTexParameteri(GL_TEXTURE_2D,
+		GL_CALL(glTexParameteri(m_target,
 			GL_TEXTURE_WRAP_S,
 			m_repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 
-		GL_CALL(glTexParameteri(GL_TEXTURE_2D,
+		GL_CALL(glTexParameteri(m_target,
 			GL_TEXTURE_WRAP_T,
 			m_repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
 	}
@@ -316,9 +504,9 @@ namespace age
 	{
 		bind();
 
-		GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
+		GL_CALL(glGenerateMipmap(m_target));
 
-		GL_CALL(glTexParameteri(GL_TEXTURE_2D,
+		GL_CALL(glTexParameteri(m_target,
 			GL_TEXTURE_MIN_FILTER,
 			m_smooth ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR));
 
@@ -329,15 +517,25 @@ namespace age
 	{
 		bind();
 
-		GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+		GL_CALL(glTexParameteri(m_target, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
 		m_has_mipmap = false;
 	}
 
+	void texture::set_pixels_flipped(bool value)
+	{
+		m_pixels_flipped = value;
+	}
+
 	uint32_t texture::get_id() const
 	{
 		return get_handle();
 	}
 
+	bool texture::is_array() const
+	{
+		return m_target == GL_TEXTURE_2D_ARRAY;
+	}
+
 	void texture::bind(const texture* tex)
 	{
 		if (tex)
@@ -346,11 +544,7 @@ namespace age
 			return;
 		}
 
-		if (m_current_bound_texture != 0)
-		{
-			GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-			m_current_bound_texture = 0;
-		}
+		gl_state::get_current().bind_texture(GL_TEXTURE_2D, 0);
 	}
 
 	uint32_t texture::get_maximum_size()
@@ -371,6 +565,52 @@ namespace age
 		return result;
 	}
 
+	texture::texture(uint32_t target)
+		: m_handle{ gen_handle() }
+		, m_target{ target }
+	{}
+
+	void texture::blit(const texture& other_texture, const uint_rect& source_area, const uint_rect& dest_area, bool flip)
+	{
+		GLuint framebuffers[2];
+		GL_CALL(glGenFramebuffers(2, framebuffers));
+
+		GLint previous_read_frame_buffer;
+		GLint previous_draw_frame_buffer;
+		GL_CALL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_frame_buffer));
+		GL_CALL(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw_frame_buffer));
+
+		auto& state = gl_state::get_current();
+		state.bind_framebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+		state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+
+		GL_CALL(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, other_texture.get_handle(), 0));
+		GL_CALL(glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, get_handle(), 0));
+
+		auto dest_top = static_cast<GLint>(dest_area.top);
+		auto dest_bottom = static_cast<GLint>(dest_area.top + dest_area.height);
+
+		// Swapping the destination rows flips the copy
+		GL_CALL(glBlitFramebuffer(
+			static_cast<GLint>(source_area.left),
+			static_cast<GLint>(source_area.top),
+			static_cast<GLint>(source_area.left + source_area.width),
+			static_cast<GLint>(source_area.top + source_area.height),
+			static_cast<GLint>(dest_area.left),
+			flip ? dest_bottom : dest_top,
+			static_cast<GLint>(dest_area.left + dest_area.width),
+			flip ? dest_top : dest_bottom,
+			GL_COLOR_BUFFER_BIT,
+			GL_NEAREST));
+
+		state.bind_framebuffer(GL_READ_FRAMEBUFFER, static_cast<uint32_t>(previous_read_frame_buffer));
+		state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, static_cast<uint32_t>(previous_draw_frame_buffer));
+
+		state.forget_framebuffer(framebuffers[0]);
+		state.forget_framebuffer(framebuffers[1]);
+		GL_CALL(glDeleteFramebuffers(2, framebuffers));
+	}
+
 	uint32_t texture::gen_handle()
 	{
 		GLuint handle;
@@ -381,6 +621,7 @@ namespace age
 
 	void texture::delete_handle(uint32_t handle)
 	{
+		gl_state::get_current().forget_texture(handle);
 		GL_CALL(glDeleteTextures(1, &handle));
 	}
 }
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "graphics/texture_array.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+#include "graphics/gl_state.h"
+#include "graphics/render_target.h"
+#include "utility/gl_check.h"
+
+namespace age
+{
+	texture_array::texture_array()
+		: texture{ GL_TEXTURE_2D_ARRAY }
+	{}
+
+	void texture_array::create(const glm::u32vec2& size, uint32_t num_layers)
+	{
+		if (num_layers == 0)
+			throw std::runtime_error{ "TEXTURE_ARRAY::CREATE AT LEAST ONE LAYER IS NEEDED!" };
+
+		check_size(size, "TEXTURE_ARRAY::CREATE INVALID LAYER SIZE!");
+
+		render_target::flush_pending_draws(*this);
+
+		m_size = size;
+		m_num_layers = 0;
+		m_capacity = 0;
+
+		reallocate(num_layers);
+		m_num_layers = num_layers;
+	}
+
+	void texture_array::load(const std::vector<image>& images)
+	{
+		if (images.empty())
+			throw std::runtime_error{ "TEXTURE_ARRAY::LOAD NO IMAGES!" };
+
+		create(images.front().get_size(), static_cast<uint32_t>(images.size()));
+
+		for (uint32_t i = 0; i < m_num_layers; ++i)
+		{
+			if (images[i].get_size() != m_size)
+				throw std::runtime_error{ "TEXTURE_ARRAY::LOAD ALL IMAGES NEED TO HAVE THE SAME SIZE!" };
+
+			update(i, images[i]);
+		}
+	}
+
+	uint32_t texture_array::add_layer(const image& img)
+	{
+		return add_layers(std::vector<image>{ img });
+	}
+
+	uint32_t texture_array::add_layers(const std::vector<image>& images)
+	{
+		uint32_t first_layer = m_num_layers;
+
+		if (images.empty())
+			return first_layer;
+
+		if (m_capacity == 0)
+		{
+			check_size(images.front().get_size(), "TEXTURE_ARRAY::ADD_LAYERS INVALID LAYER SIZE!");
+			m_size = images.front().get_size();
+		}
+
+		for (const auto& img : images)
+		{
+			if (img.get_size() != m_size)
+				throw std::runtime_error{ "TEXTURE_ARRAY::ADD_LAYERS IMAGE SIZE DOES NOT MATCH THE LAYER SIZE!" };
+		}
+
+		uint32_t num_layers = m_num_layers + static_cast<uint32_t>(images.size());
+		if (num_layers > m_capacity)
+		{
+			//Doubling keeps the number of copies low when layers are added one by one
+			uint32_t capacity = std::max(num_layers, std::min(m_capacity * 2, get_layer_limit()));
+			reallocate(capacity);
+		}
+
+		m_num_layers = num_layers;
+
+		for (uint32_t i = 0; i < images.size(); ++i)
+			update(first_layer + i, images[i]);
+
+		return first_layer;
+	}
+
+	void texture_array::reserve(uint32_t num_layers)
+	{
+		if (m_capacity == 0)
+			throw std::runtime_error{ "TEXTURE_ARRAY::RESERVE THE LAYER SIZE IS UNKNOWN BEFORE THE FIRST LAYER!" };
+
+		if (num_layers > m_capacity)
+			reallocate(num_layers);
+	}
+
+	void texture_array::update(uint32_t layer, const uint8_t* pixels)
+	{
+		update(layer, pixels, uint_rect{ glm::u32vec2{}, get_size() });
+	}
+
+	void texture_array::update(uint32_t layer, const uint8_t* pixels, const uint_rect& area)
+	{
+		assert(layer < m_num_layers);
+		assert(area.left + area.width <= m_size.x);
+		assert(area.top + area.height <= m_size.y);
+
+		if (pixels)
+		{
+			render_target::flush_pending_draws(*this);
+
+			bind();
+
+			GL_CALL(glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+				0,
+				static_cast<GLint>(area.left),
+				static_cast<GLint>(area.top),
+				static_cast<GLint>(layer),
+				static_cast<GLsizei>(area.width),
+				static_cast<GLsizei>(area.height),
+				1,
+				GL_RGBA,
+				GL_UNSIGNED_BYTE,
+				pixels));
+
+			GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+			m_has_mipmap = false;
+		}
+	}
+
+	void texture_array::update(uint32_t layer, const image& img)
+	{
+		update(layer, img.get_pixel_ptr(), uint_rect{ glm::u32vec2{}, img.get_size() });
+	}
+
+	void texture_array::update(uint32_t layer, const image& img, const glm::u32vec2& dest)
+	{
+		update(layer, img.get_pixel_ptr(), uint_rect{ dest, img.get_size() });
+	}
+
+	uint32_t texture_array::get_num_layers() const
+	{
+		return m_num_layers;
+	}
+
+	uint32_t texture_array::get_capacity() const
+	{
+		return m_capacity;
+	}
+
+	float texture_array::get_layer_offset(uint32_t layer) const
+	{
+		return static_cast<float>(layer) * 2.0f * static_cast<float>(m_size.y);
+	}
+
+	image texture_array::copy_to_image(uint32_t layer) const
+	{
+		assert(layer < m_num_layers);
+
+		image result{};
+
+		GLuint framebuffer;
+		GL_CALL(glGenFramebuffers(1, &framebuffer));
+
+		if (framebuffer)
+		{
+			std::vector<std::uint8_t> pixels(static_cast<std::size_t>(m_size.x) * static_cast<std::size_t>(m_size.y) * 4);
+
+			GLint previous_frame_buffer;
+			GL_CALL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_frame_buffer));
+
+			auto& state = gl_state::get_current();
+			state.bind_framebuffer(GL_FRAMEBUFFER, framebuffer);
+			GL_CALL(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, get_handle(), 0, static_cast<GLint>(layer)));
+			GL_CALL(glReadPixels(0, 0, m_size.x, m_size.y, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]));
+
+			state.bind_framebuffer(GL_FRAMEBUFFER, static_cast<uint32_t>(previous_frame_buffer));
+			GL_CALL(glDeleteFramebuffers(1, &framebuffer));
+
+			result.create(m_size, pixels.data());
+		}
+
+		return result;
+	}
+
+	uint32_t texture_array::get_maximum_layers()
+	{
+		static bool checked = false;
+		static uint32_t result = 0;
+
+		if (!checked)
+		{
+			checked = true;
+
+			GLint layers;
+			GL_CALL(glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layers));
+
+			result = layers;
+		}
+
+		return result;
+	}
+
+	void texture_array::reallocate(uint32_t capacity)
+	{
+		if (capacity > get_layer_limit())
+			throw std::runtime_error{ "TEXTURE_ARRAY::REALLOCATE TOO MANY LAYERS!" };
+
+		//Texture arrays can't be resized in place, so the layers are copied into new storage on the GPU
+		uint32_t handle = gen_handle();
+
+		gl_state::get_current().bind_texture(GL_TEXTURE_2D_ARRAY, handle);
+
+		GL_CALL(glTexImage3D(GL_TEXTURE_2D_ARRAY,
+			0,
+			GL_RGBA8,
+			static_cast<GLsizei>(m_size.x),
+			static_cast<GLsizei>(m_size.y),
+			static_cast<GLsizei>(capacity),
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			nullptr));
+
+		GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, m_repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
+		GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, m_repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
+		GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+		GL_CALL(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_smooth ? GL_LINEAR : GL_NEAREST));
+
+		if (m_num_layers > 0)
+		{
+			GL_CALL(glCopyImageSubData(
+				get_handle(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+				handle, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+				static_cast<GLsizei>(m_size.x),
+				static_cast<GLsizei>(m_size.y),
+				static_cast<GLsizei>(m_num_layers)));
+		}
+
+		m_handle.reset(handle);
+		m_capacity = capacity;
+		m_has_mipmap = false;
+	}
+
+	uint32_t texture_array::get_layer_limit() const
+	{
+		//The last layer ends at (2 * layers - 1) * height, which must not exceed 2^24
+		uint64_t encodable = ((uint64_t{ 1 } << 24) / m_size.y + 1) / 2;
+
+		return static_cast<uint32_t>(std::min<uint64_t>(get_maximum_layers(), encodable));
+	}
+
+	void texture_array::check_size(const glm::u32vec2& size, const char* message) const
+	{
+		uint32_t max_size = get_maximum_size();
+
+		if (size.x == 0 || size.y == 0 || size.x > max_size || size.y > max_size)
+			throw std::runtime_error{ message };
+	}
+}
@@ -0,0 +1,253 @@
+#include "graphics/texture_atlas.h"
+
+#include <stdexcept>
+#include <sstream>
+#include <limits>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+namespace age
+{
+	texture_atlas::texture_atlas(const glm::u32vec2& page_size, uint32_t padding, uint32_t extrusion)
+		: m_page_size{ page_size }
+		, m_padding{ padding }
+		, m_extrusion{ extrusion }
+	{}
+
+	atlas_region texture_atlas::insert(const image& img)
+	{
+		return insert(img, uint_rect{ glm::u32vec2{ 0, 0 }, img.get_size() });
+	}
+
+	atlas_region texture_atlas::insert(const image& img, const uint_rect& area)
+	{
+		assert(area.left + area.width <= img.get_size().x);
+		assert(area.top + area.height <= img.get_size().y);
+
+		if (area.width == 0 || area.height == 0)
+			return atlas_region{};
+
+		//Every entry is surrounded by its extruded border and followed by the padding
+		glm::u32vec2 extruded_size{ area.width + 2 * m_extrusion, area.height + 2 * m_extrusion };
+		glm::u32vec2 packed_size{ extruded_size.x + m_padding, extruded_size.y + m_padding };
+
+		//The padding is placed like part of the entry, so it has to fit as well
+		if (packed_size.x > m_page_size.x || packed_size.y > m_page_size.y)
+		{
+			std::stringstream message;
+			message << "Failure inserting into texture atlas: image (" << area.width << ", " << area.height << ") does not fit into a page of size (" << m_page_size.x << ", " << m_page_size.y << ")";
+
+			throw std::runtime_error{ message.str() };
+		}
+
+		page* target_page = nullptr;
+		std::optional<placement> place;
+
+		for (auto& p : m_pages)
+		{
+			place = find_placement(p, packed_size);
+			if (place)
+			{
+				target_page = &p;
+				break;
+			}
+		}
+
+		if (!place)
+		{
+			target_page = &add_page();
+			place = find_placement(*target_page, packed_size);
+
+			if (!place)
+			{
+				m_pages.pop_back();
+				throw std::runtime_error{ "TEXTURE_ATLAS::INSERT ENTRY DOES NOT FIT INTO AN EMPTY PAGE!" };
+			}
+		}
+
+		add_skyline_level(*target_page, *place, packed_size);
+
+		//Copy the pixels and repeat the edge pixels into the extruded border, which avoids bleeding when sampling with filtering
+		m_scratch.resize(static_cast<size_t>(extruded_size.x) * extruded_size.y * 4);
+
+		const uint8_t* src = img.get_pixel_ptr();
+		size_t src_pitch = static_cast<size_t>(img.get_size().x) * 4;
+
+		for (uint32_t y = 0; y < extruded_size.y; ++y)
+		{
+			uint32_t src_y = area.top + std::min(y > m_extrusion ? y - m_extrusion : 0, area.height - 1);
+			uint8_t* dst_row = m_scratch.data() + static_cast<size_t>(y) * extruded_size.x * 4;
+			const uint8_t* src_row = src + src_y * src_pitch;
+
+			for (uint32_t x = 0; x < m_extrusion; ++x)
+				std::memcpy(dst_row + x * 4, src_row + area.left * 4, 4);
+
+			std::memcpy(dst_row + m_extrusion * 4, src_row + area.left * 4, static_cast<size_t>(area.width) * 4);
+
+			for (uint32_t x = m_extrusion + area.width; x < extruded_size.x; ++x)
+				std::memcpy(dst_row + x * 4, src_row + (area.left + area.width - 1) * 4, 4);
+		}
+
+		glm::u32vec2 position = place->position;
+		target_page->tex.update(m_scratch.data(), uint_rect{ position, extruded_size });
+
+		return atlas_region{ &target_page->tex, uint_rect{ glm::u32vec2{ position.x + m_extrusion, position.y + m_extrusion }, glm::u32vec2{ area.width, area.height } } };
+	}
+
+	void texture_atlas::clear()
+	{
+		m_pages.clear();
+	}
+
+	size_t texture_atlas::get_num_pages() const
+	{
+		return m_pages.size();
+	}
+
+	const texture& texture_atlas::get_page(size_t index) const
+	{
+		return m_pages[index].tex;
+	}
+
+	const glm::u32vec2& texture_atlas::get_page_size() const
+	{
+		return m_page_size;
+	}
+
+	uint32_t texture_atlas::get_padding() const
+	{
+		return m_padding;
+	}
+
+	uint32_t texture_atlas::get_extrusion() const
+	{
+		return m_extrusion;
+	}
+
+	void texture_atlas::set_smooth(bool value)
+	{
+		m_smooth = value;
+
+		for (auto& p : m_pages)
+			p.tex.set_smooth(value);
+	}
+
+	bool texture_atlas::get_smooth() const
+	{
+		return m_smooth;
+	}
+
+	std::optional<uint32_t> texture_atlas::fit(const page& p, size_t node_index, const glm::u32vec2& size) const
+	{
+		const auto& skyline = p.skyline;
+
+		if (skyline[node_index].x + size.x > m_page_size.x)
+			return std::nullopt;
+
+		//The rectangle rests on the highest node below its width
+		uint32_t y = 0;
+		uint32_t remaining_width = size.x;
+
+		for (size_t i = node_index; remaining_width > 0; ++i)
+		{
+			if (i == skyline.size())
+				return std::nullopt;
+
+			y = std::max(y, skyline[i].y);
+
+			if (y + size.y > m_page_size.y)
+				return std::nullopt;
+
+			remaining_width -= std::min(remaining_width, skyline[i].width);
+		}
+
+		return y;
+	}
+
+	std::optional<texture_atlas::placement> texture_atlas::find_placement(const page& p, const glm::u32vec2& size) const
+	{
+		std::optional<placement> best;
+		uint32_t best_bottom = std::numeric_limits<uint32_t>::max();
+		uint32_t best_width = std::numeric_limits<uint32_t>::max();
+
+		for (size_t i = 0; i < p.skyline.size(); ++i)
+		{
+			auto y = fit(p, i, size);
+			if (!y)
+				continue;
+
+			uint32_t bottom = *y + size.y;
+			const auto& node = p.skyline[i];
+
+			//Bottom left rule, ties are broken by the narrower node to keep the skyline flat
+			if (bottom < best_bottom || (bottom == best_bottom && node.width < best_width))
+			{
+				best = placement{ i, glm::u32vec2{ node.x, *y } };
+				best_bottom = bottom;
+				best_width = node.width;
+			}
+		}
+
+		return best;
+	}
+
+	void texture_atlas::add_skyline_level(page& p, const placement& place, const glm::u32vec2& size)
+	{
+		auto& skyline = p.skyline;
+
+		skyline_node new_node{ place.position.x, place.position.y + size.y, size.x };
+		skyline.insert(skyline.begin() + place.node_index, new_node);
+
+		//Shrink or remove the nodes which are now covered by the new one
+		for (size_t i = place.node_index + 1; i < skyline.size(); )
+		{
+			auto& previous = skyline[i - 1];
+			auto& node = skyline[i];
+
+			uint32_t previous_end = previous.x + previous.width;
+			if (node.x >= previous_end)
+				break;
+
+			uint32_t shrink = previous_end - node.x;
+
+			if (node.width <= shrink)
+			{
+				skyline.erase(skyline.begin() + i);
+				continue;
+			}
+
+			node.x += shrink;
+			node.width -= shrink;
+			break;
+		}
+
+		//Merge neighbours on the same level
+		for (size_t i = 0; i + 1 < skyline.size(); )
+		{
+			if (skyline[i].y == skyline[i + 1].y)
+			{
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+				continue;
+			}
+
+			++i;
+		}
+	}
+
+	texture_atlas::page& texture_atlas::add_page()
+	{
+		auto& p = m_pages.emplace_back();
+
+		p.tex.create(m_page_size);
+		p.tex.set_smooth(m_smooth);
+
+		//Start fully transparent, so that padding never shows garbage when it is sampled by filtering
+		p.tex.clear(color{ 0, 0, 0, 0 });
+
+		p.skyline.push_back(skyline_node{ 0, 0, m_page_size.x });
+
+		return p;
+	}
+}
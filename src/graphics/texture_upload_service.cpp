@@ -0,0 +1,231 @@
+#include "graphics/texture_upload_service.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <glad/glad.h>
+
+#include "engine.h"
+#include "graphics/gl_state.h"
+#include "system/transient_context_lock.h"
+#include "utility/gl_check.h"
+
+namespace age
+{
+	texture_upload_service::texture_upload_service(size_t num_pixel_buffers)
+		: m_pixel_buffers(std::max(num_pixel_buffers, size_t{ 1 }))
+	{
+		//Creating the context here keeps the first upload from waiting for it
+		engine::get_instance()->get_render_window().prewarm_shared_contexts(1);
+
+		m_thread = std::thread{ &texture_upload_service::work, this };
+	}
+
+	texture_upload_service::~texture_upload_service()
+	{
+		{
+			std::lock_guard lock{ m_queue_mutex };
+			m_exit = true;
+			m_queue_pending.notify_one();
+		}
+
+		m_thread.join();
+	}
+
+	std::shared_future<void> texture_upload_service::load(texture& tex, std::string_view filename)
+	{
+		return add_job(tex, [filename = std::string{ filename }]()
+		{
+			image img;
+			img.load(filename);
+
+			return img;
+		});
+	}
+
+	std::shared_future<void> texture_upload_service::load(texture& tex, std::vector<std::byte> data)
+	{
+		return add_job(tex, [data = std::move(data)]()
+		{
+			image img;
+			img.load(data.data(), data.size());
+
+			return img;
+		});
+	}
+
+	std::shared_future<void> texture_upload_service::load(texture& tex, image img)
+	{
+		//std::function needs a copyable callable, so the image is moved into a shared one
+		auto shared_img = std::make_shared<image>(std::move(img));
+
+		return add_job(tex, [shared_img]() { return std::move(*shared_img); });
+	}
+
+	size_t texture_upload_service::get_num_pending_uploads() const
+	{
+		return m_num_pending_uploads;
+	}
+
+	std::shared_future<void> texture_upload_service::add_job(texture& tex, std::function<image()> decode)
+	{
+		if (tex.is_array())
+			throw std::runtime_error{ "TEXTURE_UPLOAD_SERVICE::ADD_JOB TEXTURE ARRAYS ARE NOT SUPPORTED!" };
+
+		upload_job job{ &tex, std::move(decode), std::promise<void>{} };
+		std::shared_future<void> result = job.promise.get_future().share();
+
+		++m_num_pending_uploads;
+
+		std::lock_guard lock{ m_queue_mutex };
+		m_job_queue.push_back(std::move(job));
+		m_queue_pending.notify_one();
+
+		return result;
+	}
+
+	void texture_upload_service::work()
+	{
+		//Stays active for the whole lifetime of the thread
+		transient_context_lock context_lock;
+
+		for (auto& buffer : m_pixel_buffers)
+			GL_CALL(glGenBuffers(1, &buffer.id));
+
+		while (true)
+		{
+			std::optional<upload_job> job;
+
+			{
+				std::unique_lock lock{ m_queue_mutex };
+
+				//While uploads are in flight the thread keeps polling their fences instead of sleeping
+				if (m_pending_uploads.empty())
+					m_queue_pending.wait(lock, [this]() -> bool { return m_exit || !m_job_queue.empty(); });
+
+				if (m_exit) break;
+
+				if (!m_job_queue.empty())
+				{
+					job.emplace(std::move(m_job_queue.front()));
+					m_job_queue.pop_front();
+				}
+			}
+
+			if (job)
+				upload(*job);
+
+			retire_uploads(!job);
+		}
+
+		while (!m_pending_uploads.empty())
+			retire_oldest_upload();
+
+		auto& state = gl_state::get_current();
+		for (auto& buffer : m_pixel_buffers)
+		{
+			state.forget_buffer(buffer.id);
+			GL_CALL(glDeleteBuffers(1, &buffer.id));
+		}
+	}
+
+	void texture_upload_service::upload(upload_job& job)
+	{
+		auto& state = gl_state::get_current();
+
+		try
+		{
+			image img = job.decode();
+
+			const auto& size = img.get_size();
+			size_t num_bytes = static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 4;
+
+			//Allocates the storage before a pixel buffer is bound, otherwise glTexImage2D would read from it
+			job.target->create(size);
+
+			//The pixel buffers are used in turn, the previous upload from the next one has to be finished before it is overwritten
+			size_t index = m_next_pixel_buffer;
+			m_next_pixel_buffer = (m_next_pixel_buffer + 1) % m_pixel_buffers.size();
+
+			auto uses_buffer = [index](const pending_upload& pending) { return pending.pixel_buffer == index; };
+			while (std::any_of(m_pending_uploads.begin(), m_pending_uploads.end(), uses_buffer))
+				retire_oldest_upload();
+
+			auto& buffer = m_pixel_buffers[index];
+			state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+
+			if (buffer.capacity < num_bytes)
+			{
+				GL_CALL(glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(num_bytes), nullptr, GL_STREAM_DRAW));
+				buffer.capacity = num_bytes;
+			}
+
+			void* destination = GL_CALL(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(num_bytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+			if (!destination)
+				throw std::runtime_error{ "TEXTURE_UPLOAD_SERVICE::UPLOAD FAILED TO MAP THE PIXEL BUFFER!" };
+
+			std::memcpy(destination, img.get_pixel_ptr(), num_bytes);
+			GL_CALL(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+			//With a pixel unpack buffer bound the pixel pointer is an offset into the buffer
+			job.target->bind();
+			GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+
+			state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			void* fence = GL_CALL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+			//Makes sure the commands reach the GPU, the fence is never signaled otherwise
+			GL_CALL(glFlush());
+
+			m_pending_uploads.push_back(pending_upload{ fence, std::move(job.promise), index });
+		}
+		catch (...)
+		{
+			state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			job.promise.set_exception(std::current_exception());
+			--m_num_pending_uploads;
+		}
+	}
+
+	void texture_upload_service::retire_uploads(bool wait)
+	{
+		while (!m_pending_uploads.empty())
+		{
+			auto fence = static_cast<GLsync>(m_pending_uploads.front().fence);
+
+			GLenum result = GL_CALL(glClientWaitSync(fence, 0, 0));
+			if (result == GL_TIMEOUT_EXPIRED && wait)
+			{
+				//Short enough that new requests are picked up quickly
+				constexpr GLuint64 timeout_ns = 1000000;
+				result = GL_CALL(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns));
+				wait = false;
+			}
+
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED)
+				return;
+
+			retire_oldest_upload();
+		}
+	}
+
+	void texture_upload_service::retire_oldest_upload()
+	{
+		auto& pending = m_pending_uploads.front();
+		auto fence = static_cast<GLsync>(pending.fence);
+
+		constexpr GLuint64 timeout_ns = 1000000000;
+		while (GL_CALL(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns)) == GL_TIMEOUT_EXPIRED);
+
+		GL_CALL(glDeleteSync(fence));
+
+		pending.promise.set_value();
+		--m_num_pending_uploads;
+
+		m_pending_uploads.pop_front();
+	}
+}
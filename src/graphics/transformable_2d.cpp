@@ -1,6 +1,10 @@
 #include "graphics/transformable_2d.h"
 
+#include <array>
+#include <limits>
+
 #include <glm/trigonometric.hpp>
+#include <glm/common.hpp>
 
 namespace age
 {
@@ -128,4 +132,27 @@ namespace age
 
 		return m_inverse_transform;
 	}
-}
\ No newline at end of file
+
+	float_rect transform_rect(const glm::mat4& transform, const float_rect& rect)
+	{
+		const std::array<glm::vec2, 4> corners
+		{
+			glm::vec2{ rect.left, rect.top },
+			glm::vec2{ rect.left + rect.width, rect.top },
+			glm::vec2{ rect.left, rect.top + rect.height },
+			glm::vec2{ rect.left + rect.width, rect.top + rect.height }
+		};
+
+		glm::vec2 min{ std::numeric_limits<float>::max() };
+		glm::vec2 max{ std::numeric_limits<float>::lowest() };
+
+		for (const auto& corner : corners)
+		{
+			glm::vec2 point{ transform * glm::vec4{ corner.x, corner.y, 0.0f, 1.0f } };
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		return float_rect{ min, max - min };
+	}
+}
@@ -2,6 +2,8 @@
 
 #include <glad/glad.h>
 
+#include "graphics/render_stats.h"
+#include "graphics/gl_state.h"
 #include "utility/gl_check.h"
 
 namespace age
@@ -12,14 +14,7 @@ namespace age
 
 	void uniform_buffer_object::bind() const
 	{
-		auto handle = get_handle();
-
-		if (handle != m_current_bound_uniform_buffer_object)
-		{
-			GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, handle));
-
-			m_current_bound_uniform_buffer_object = handle;
-		}
+		gl_state::get_current().bind_buffer(GL_UNIFORM_BUFFER, get_handle());
 	}
 
 	void uniform_buffer_object::buffer_data(size_t size, const void* data)
@@ -27,6 +22,7 @@ namespace age
 		bind();
 
 		GL_CALL(glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STATIC_DRAW));
+		render_stats::get_current().uniform_bytes += size;
 	}
 
 	void uniform_buffer_object::buffer_sub_data(size_t offset, size_t size, const void* data)
@@ -34,16 +30,17 @@ namespace age
 		bind();
 
 		GL_CALL(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+		render_stats::get_current().uniform_bytes += size;
 	}
 
 	void uniform_buffer_object::bind_buffer_base(uint32_t index)
 	{
-		GL_CALL(glBindBufferBase(GL_UNIFORM_BUFFER, index, get_handle()));
+		gl_state::get_current().bind_buffer_base(GL_UNIFORM_BUFFER, index, get_handle());
 	}
 
 	void uniform_buffer_object::bind_buffer_range(uint32_t index, size_t offset, size_t size)
 	{
-		GL_CALL(glBindBufferRange(GL_UNIFORM_BUFFER, index, get_handle(), offset, size));
+		gl_state::get_current().bind_buffer_range(GL_UNIFORM_BUFFER, index, get_handle(), offset, size);
 	}
 
 	uint32_t uniform_buffer_object::gen_handle()
@@ -57,6 +54,7 @@ namespace age
 
 	void uniform_buffer_object::delete_handle(uint32_t handle)
 	{
+		gl_state::get_current().forget_buffer(handle);
 		GL_CALL(glDeleteBuffers(1, &handle));
 	}
 }
\ No newline at end of file
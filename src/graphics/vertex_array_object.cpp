@@ -2,6 +2,7 @@
 
 #include <glad/glad.h>
 
+#include "graphics/gl_state.h"
 #include "utility/gl_check.h"
 
 namespace age
@@ -12,26 +13,12 @@ namespace age
 
 	void vertex_array_object::bind() const
 	{
-		auto handle = get_handle();
-
-		if (m_current_bound_array != handle)
-		{
-			GL_CALL(glBindVertexArray(get_handle()));
-
-			m_current_bound_array = handle;
-		}
+		gl_state::get_current().bind_vertex_array(get_handle());
 	}
 
 	void vertex_array_object::release() const
 	{
-		auto handle = get_handle();
-
-		if (m_current_bound_array == handle)
-		{
-			GL_CALL(glBindVertexArray(0));
-
-			m_current_bound_array = 0;
-		}
+		gl_state::get_current().bind_vertex_array(0);
 	}
 
 	uint32_t vertex_array_object::create_handle()
@@ -45,6 +32,7 @@ namespace age
 
 	void vertex_array_object::delete_handle(uint32_t handle)
 	{
+		gl_state::get_current().forget_vertex_array(handle);
 		GL_CALL(glDeleteVertexArrays(1, &handle));
 	}
 }
\ No newline at end of file
@@ -3,7 +3,11 @@
 #include <glad/glad.h>
 
 #include <stdexcept>
+#include <cstring>
 
+#include "engine.h"
+#include "graphics/render_stats.h"
+#include "graphics/gl_state.h"
 #include "utility/gl_check.h"
 
 namespace age
@@ -13,17 +17,22 @@ namespace age
 		, m_target{ target }
 	{}
 
+	vertex_buffer_object::~vertex_buffer_object()
+	{
+		release_stream_storage();
+	}
+
 	void vertex_buffer_object::bind() const
 	{
-		auto handle = get_handle();
-		auto& current_bound_buffer = m_current_bound_buffer[static_cast<uint32_t>(m_target)];
+		gl_state::get_current().bind_buffer(convert_target(m_target), get_handle());
+	}
 
-		if (current_bound_buffer != handle)
-		{
-			GL_CALL(glBindBuffer(convert_target(m_target), get_handle()));
+	void vertex_buffer_object::bind_range(uint32_t index, size_t offset, size_t size_in_bytes) const
+	{
+		if (m_target != target::shader_storage && m_target != target::uniform)
+			throw std::runtime_error{ "VERTEX_BUFFER_OBJECT::BIND_RANGE TARGET IS NOT INDEXED!" };
 
-			current_bound_buffer = handle;
-		}
+		gl_state::get_current().bind_buffer_range(convert_target(m_target), index, get_handle(), offset, size_in_bytes);
 	}
 
 	void vertex_buffer_object::buffer_data(const void* data, size_t size_in_bytes, usage usage)
@@ -31,6 +40,8 @@ namespace age
 		bind();
 
 		GL_CALL(glBufferData(convert_target(m_target), size_in_bytes, data, convert_usage(usage)));
+		if (data)
+			record_upload(size_in_bytes);
 
 		m_last_buffer_size[static_cast<uint32_t>(m_target)] = size_in_bytes;
 		m_last_buffer_usage[static_cast<uint32_t>(m_target)] = usage;
@@ -44,6 +55,8 @@ namespace age
 
 		GL_CALL(glBufferData(target, m_last_buffer_size[static_cast<uint32_t>(m_target)], nullptr, convert_usage(m_last_buffer_usage[static_cast<uint32_t>(m_target)])));
 		GL_CALL(glBufferData(target, size_in_bytes, data, convert_usage(usage)));
+		if (data)
+			record_upload(size_in_bytes);
 
 		m_last_buffer_size[static_cast<uint32_t>(m_target)] = size_in_bytes;
 		m_last_buffer_usage[static_cast<uint32_t>(m_target)] = usage;
@@ -54,6 +67,197 @@ namespace age
 		bind();
 
 		GL_CALL(glBufferSubData(convert_target(m_target), offset, size_in_bytes, data));
+		record_upload(size_in_bytes);
+	}
+
+	void vertex_buffer_object::create_stream(size_t region_size_in_bytes)
+	{
+		release_stream_storage();
+
+		//Ranges streamed before belong to the old storage, so the generation keeps counting up
+		auto generation = m_stream.generation + 1;
+
+		m_stream = stream_state{};
+		m_stream.region_size = region_size_in_bytes;
+		m_stream.generation = generation;
+
+		allocate_stream_storage();
+	}
+
+	size_t vertex_buffer_object::stream_data(const void* data, size_t size_in_bytes, size_t alignment)
+	{
+		if (!is_streaming())
+			throw std::runtime_error{ "VERTEX_BUFFER_OBJECT::STREAM_DATA BUFFER IS NOT STREAMING!" };
+
+		auto align = [alignment](size_t value) { return (value + alignment - 1) / alignment * alignment; };
+
+		size_t region_begin = m_stream.region * m_stream.region_size;
+		size_t offset = align(region_begin + m_stream.offset);
+
+		if (offset + size_in_bytes > region_begin + m_stream.region_size)
+		{
+			if (align(size_in_bytes) + alignment > m_stream.region_size)
+			{
+				//A single upload does not fit into a region, so the whole ring has to grow
+				release_stream_storage();
+
+				size_t region_size = m_stream.region_size;
+				while (align(size_in_bytes) + alignment > region_size)
+					region_size *= 2;
+
+				auto generation = m_stream.generation + 1;
+
+				m_stream = stream_state{};
+				m_stream.region_size = region_size;
+				m_stream.generation = generation;
+
+				allocate_stream_storage();
+			}
+			else
+			{
+				next_stream_region();
+			}
+
+			region_begin = m_stream.region * m_stream.region_size;
+			offset = align(region_begin);
+		}
+
+		write_stream_data(data, offset, size_in_bytes);
+		record_upload(size_in_bytes);
+		m_stream.offset = offset + size_in_bytes - region_begin;
+
+		return offset;
+	}
+
+	uint32_t vertex_buffer_object::get_id() const
+	{
+		return get_handle();
+	}
+
+	void vertex_buffer_object::allocate_stream_storage()
+	{
+		auto gl_target = convert_target(m_target);
+		auto total_size = static_cast<GLsizeiptr>(m_stream.region_size * stream_regions);
+
+		//Persistent mapping needs immutable storage, which can not be respecified. So every allocation gets a fresh handle
+		m_handle.reset(create_handle());
+		bind();
+
+		m_stream.persistent = engine::get_instance()->has_buffer_storage();
+
+		if (m_stream.persistent)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			GL_CALL(glBufferStorage(gl_target, total_size, nullptr, flags));
+			m_stream.mapped_data = static_cast<uint8_t*>(GL_CALL(glMapBufferRange(gl_target, 0, total_size, flags)));
+
+			if (!m_stream.mapped_data)
+				throw std::runtime_error{ "VERTEX_BUFFER_OBJECT::ALLOCATE_STREAM_STORAGE MAPPING FAILED!" };
+		}
+		else
+		{
+			//OpenGL ES 3 fallback: mutable storage which gets orphaned every time the ring wraps around
+			GL_CALL(glBufferData(gl_target, total_size, nullptr, GL_STREAM_DRAW));
+		}
+
+		m_last_buffer_size[static_cast<uint32_t>(m_target)] = static_cast<size_t>(total_size);
+		m_last_buffer_usage[static_cast<uint32_t>(m_target)] = usage::stream_draw;
+	}
+
+	void vertex_buffer_object::release_stream_storage()
+	{
+		for (auto& fence : m_stream.fences)
+		{
+			if (fence)
+			{
+				GL_CALL(glDeleteSync(static_cast<GLsync>(fence)));
+				fence = nullptr;
+			}
+		}
+
+		if (m_stream.mapped_data)
+		{
+			bind();
+			GL_CALL(glUnmapBuffer(convert_target(m_target)));
+
+			m_stream.mapped_data = nullptr;
+		}
+	}
+
+	void vertex_buffer_object::next_stream_region()
+	{
+		++m_stream.generation;
+
+		if (m_stream.persistent)
+		{
+			//Everything which has been drawn from the current region is guarded by this fence
+			m_stream.fences[m_stream.region] = GL_CALL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+			m_stream.region = (m_stream.region + 1) % stream_regions;
+			m_stream.offset = 0;
+
+			if (auto fence = static_cast<GLsync>(m_stream.fences[m_stream.region]))
+			{
+				static constexpr GLuint64 timeout_ns = 1000000;
+
+				GLenum result = GL_CALL(glClientWaitSync(fence, 0, 0));
+				while (result == GL_TIMEOUT_EXPIRED)
+					result = GL_CALL(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns));
+
+				GL_CALL(glDeleteSync(fence));
+				m_stream.fences[m_stream.region] = nullptr;
+			}
+
+			return;
+		}
+
+		m_stream.region = (m_stream.region + 1) % stream_regions;
+		m_stream.offset = 0;
+
+		if (m_stream.region == 0)
+		{
+			bind();
+			GL_CALL(glBufferData(convert_target(m_target), static_cast<GLsizeiptr>(m_stream.region_size * stream_regions), nullptr, GL_STREAM_DRAW));
+		}
+	}
+
+	void vertex_buffer_object::write_stream_data(const void* data, size_t offset, size_t size_in_bytes)
+	{
+		if (m_stream.persistent)
+		{
+			std::memcpy(m_stream.mapped_data + offset, data, size_in_bytes);
+			return;
+		}
+
+		bind();
+
+		auto gl_target = convert_target(m_target);
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+
+		if (void* ptr = GL_CALL(glMapBufferRange(gl_target, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size_in_bytes), flags)))
+		{
+			std::memcpy(ptr, data, size_in_bytes);
+			GL_CALL(glUnmapBuffer(gl_target));
+		}
+	}
+
+	void vertex_buffer_object::record_upload(size_t size_in_bytes) const
+	{
+		auto& stats = render_stats::get_current();
+
+		switch (m_target)
+		{
+			case target::array:
+				stats.vertex_bytes += size_in_bytes;
+				break;
+			case target::element_array:
+				stats.element_bytes += size_in_bytes;
+				break;
+			default:
+				stats.other_buffer_bytes += size_in_bytes;
+				break;
+		}
 	}
 
 	uint32_t vertex_buffer_object::convert_target(target target_to_convert)
@@ -64,6 +268,12 @@ namespace age
 				return GL_ARRAY_BUFFER;
 			case target::element_array:
 				return GL_ELEMENT_ARRAY_BUFFER;
+			case target::draw_indirect:
+				return GL_DRAW_INDIRECT_BUFFER;
+			case target::shader_storage:
+				return GL_SHADER_STORAGE_BUFFER;
+			case target::uniform:
+				return GL_UNIFORM_BUFFER;
 			default:
 				throw std::runtime_error{ "VERTEX_BUFFER_OBJECT::CONVERT_TARGET INVALID TARGET!" };
 		}
@@ -94,6 +304,7 @@ namespace age
 
 	void vertex_buffer_object::delete_handle(uint32_t handle)
 	{
+		gl_state::get_current().forget_buffer(handle);
 		GL_CALL(glDeleteBuffers(1, &handle));
 	}
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "graphics/vertex_kernels.h"
+
+#include <cstdint>
+
+#include "utility/cpu_features.h"
+
+namespace age
+{
+	namespace
+	{
+		//x' = a * x + c * y + tx, y' = b * x + d * y + ty
+		struct affine_2d
+		{
+			float a, b, c, d, tx, ty;
+		};
+
+		struct vertex_kernels
+		{
+			void (*transform)(vertex_2d*, size_t, const affine_2d&);
+			const char* isa;
+		};
+
+		void transform_scalar(vertex_2d* vertices, size_t count, const affine_2d& m)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				float x = vertices[i].position.x;
+				float y = vertices[i].position.y;
+
+				vertices[i].position.x = m.a * x + m.c * y + m.tx;
+				vertices[i].position.y = m.b * x + m.d * y + m.ty;
+			}
+		}
+
+#ifdef AGE_SIMD_X86
+		//vertex_2d is 20 bytes, so two positions are gathered into one register as x0 y0 x1 y1
+		inline __m128 load_pair(const glm::vec2& p0, const glm::vec2& p1)
+		{
+			__m128 v = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&p0.x));
+			return _mm_loadh_pi(v, reinterpret_cast<const __m64*>(&p1.x));
+		}
+
+		inline void store_pair(glm::vec2& p0, glm::vec2& p1, __m128 v)
+		{
+			_mm_storel_pi(reinterpret_cast<__m64*>(&p0.x), v);
+			_mm_storeh_pi(reinterpret_cast<__m64*>(&p1.x), v);
+		}
+
+		void transform_sse2(vertex_2d* vertices, size_t count, const affine_2d& m)
+		{
+			const __m128 ab = _mm_setr_ps(m.a, m.b, m.a, m.b);
+			const __m128 cd = _mm_setr_ps(m.c, m.d, m.c, m.d);
+			const __m128 t = _mm_setr_ps(m.tx, m.ty, m.tx, m.ty);
+
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2)
+			{
+				__m128 v = load_pair(vertices[i].position, vertices[i + 1].position);
+				__m128 xx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+				__m128 yy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+
+				__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, ab), _mm_mul_ps(yy, cd)), t);
+				store_pair(vertices[i].position, vertices[i + 1].position, r);
+			}
+
+			transform_scalar(vertices + i, count - i, m);
+		}
+
+		AGE_TARGET_AVX2 void transform_avx2(vertex_2d* vertices, size_t count, const affine_2d& m)
+		{
+			const __m256 ab = _mm256_setr_ps(m.a, m.b, m.a, m.b, m.a, m.b, m.a, m.b);
+			const __m256 cd = _mm256_setr_ps(m.c, m.d, m.c, m.d, m.c, m.d, m.c, m.d);
+			const __m256 t = _mm256_setr_ps(m.tx, m.ty, m.tx, m.ty, m.tx, m.ty, m.tx, m.ty);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 low = load_pair(vertices[i].position, vertices[i + 1].position);
+				__m128 high = load_pair(vertices[i + 2].position, vertices[i + 3].position);
+				__m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+
+				__m256 xx = _mm256_moveldup_ps(v);
+				__m256 yy = _mm256_movehdup_ps(v);
+				__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, ab), _mm256_mul_ps(yy, cd)), t);
+
+				store_pair(vertices[i].position, vertices[i + 1].position, _mm256_castps256_ps128(r));
+				store_pair(vertices[i + 2].position, vertices[i + 3].position, _mm256_extractf128_ps(r, 1));
+			}
+
+			transform_sse2(vertices + i, count - i, m);
+		}
+#endif
+
+#ifdef AGE_SIMD_NEON
+		void transform_neon(vertex_2d* vertices, size_t count, const affine_2d& m)
+		{
+			const float ab_values[4]{ m.a, m.b, m.a, m.b };
+			const float cd_values[4]{ m.c, m.d, m.c, m.d };
+			const float t_values[4]{ m.tx, m.ty, m.tx, m.ty };
+			const float32x4_t ab = vld1q_f32(ab_values);
+			const float32x4_t cd = vld1q_f32(cd_values);
+			const float32x4_t t = vld1q_f32(t_values);
+
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2)
+			{
+				float* p0 = &vertices[i].position.x;
+				float* p1 = &vertices[i + 1].position.x;
+
+				float32x4_t v = vcombine_f32(vld1_f32(p0), vld1_f32(p1));
+				//val[0] holds x0 x0 x1 x1, val[1] holds y0 y0 y1 y1
+				float32x4x2_t split = vtrnq_f32(v, v);
+
+				float32x4_t r = vaddq_f32(vaddq_f32(vmulq_f32(split.val[0], ab), vmulq_f32(split.val[1], cd)), t);
+				vst1_f32(p0, vget_low_f32(r));
+				vst1_f32(p1, vget_high_f32(r));
+			}
+
+			transform_scalar(vertices + i, count - i, m);
+		}
+#endif
+
+		vertex_kernels select_kernels()
+		{
+#if defined(AGE_SIMD_X86)
+			if (cpu_features::has_avx2())
+				return vertex_kernels{ transform_avx2, "avx2" };
+
+			return vertex_kernels{ transform_sse2, "sse2" };
+#elif defined(AGE_SIMD_NEON)
+			return vertex_kernels{ transform_neon, "neon" };
+#else
+			return vertex_kernels{ transform_scalar, "scalar" };
+#endif
+		}
+
+		const vertex_kernels& get_kernels()
+		{
+			static const vertex_kernels kernels = select_kernels();
+			return kernels;
+		}
+
+		inline affine_2d to_affine(const glm::mat4& m)
+		{
+			return affine_2d{ m[0][0], m[0][1], m[1][0], m[1][1], m[3][0], m[3][1] };
+		}
+	}
+
+	void transform_positions(vertex_2d vertices[], size_t count, const glm::mat4& transform)
+	{
+		get_kernels().transform(vertices, count, to_affine(transform));
+	}
+
+	void set_colors(vertex_2d vertices[], size_t count, const color& value)
+	{
+		//A single 4 byte store per vertex, nothing to gain from SIMD
+		for (size_t i = 0; i < count; ++i)
+			vertices[i].color = value;
+	}
+
+	const char* get_vertex_kernels_isa()
+	{
+		return get_kernels().isa;
+	}
+}
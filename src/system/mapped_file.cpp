@@ -0,0 +1,175 @@
+#include "system/mapped_file.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(ANDROID) || defined(__ANDROID__)
+	#include "system/assetstream.h"
+#elif defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace age
+{
+	mapped_file::mapped_file(std::string_view fn)
+	{
+		open(fn);
+	}
+
+	mapped_file::~mapped_file()
+	{
+		close();
+	}
+
+	mapped_file::mapped_file(mapped_file&& other) noexcept
+		: m_data{ std::exchange(other.m_data, nullptr) }
+		, m_size{ std::exchange(other.m_size, 0) }
+		, m_mapped{ std::exchange(other.m_mapped, false) }
+		, m_buffer{ std::move(other.m_buffer) }
+	{}
+
+	mapped_file& mapped_file::operator = (mapped_file&& other) noexcept
+	{
+		if (this == &other) return *this;
+
+		close();
+
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_mapped = std::exchange(other.m_mapped, false);
+		m_buffer = std::move(other.m_buffer);
+
+		return *this;
+	}
+
+	void mapped_file::open(std::string_view fn)
+	{
+		close();
+
+		std::string filename{ fn };
+
+#if defined(ANDROID) || defined(__ANDROID__)
+		//Assets are packed into the apk, so they are read instead
+		assetistream is{ filename };
+
+		is.seekg(0, std::ios::end);
+		auto size = is.tellg();
+		is.seekg(0, std::ios::beg);
+
+		if (!is || size < 0)
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO OPEN " + filename + "!" };
+
+		m_buffer.resize(static_cast<size_t>(size));
+		is.read(reinterpret_cast<char*>(m_buffer.data()), size);
+
+		m_data = m_buffer.data();
+		m_size = m_buffer.size();
+#elif defined(_WIN32)
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO OPEN " + filename + "!" };
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO GET THE SIZE OF " + filename + "!" };
+		}
+
+		//Empty files can't be mapped
+		if (size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		//The view keeps the mapping alive, so both handles can be closed right away
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+
+		if (!mapping)
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO MAP " + filename + "!" };
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+
+		if (!data)
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO MAP " + filename + "!" };
+
+		m_data = static_cast<const std::byte*>(data);
+		m_size = static_cast<size_t>(size.QuadPart);
+		m_mapped = true;
+#else
+		int file = ::open(filename.c_str(), O_RDONLY);
+		if (file < 0)
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO OPEN " + filename + "!" };
+
+		struct stat status;
+		if (fstat(file, &status) != 0)
+		{
+			::close(file);
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO GET THE SIZE OF " + filename + "!" };
+		}
+
+		//Empty files can't be mapped
+		if (status.st_size == 0)
+		{
+			::close(file);
+			return;
+		}
+
+		//The mapping stays valid after the file is closed
+		void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		::close(file);
+
+		if (data == MAP_FAILED)
+			throw std::runtime_error{ "MAPPED_FILE::OPEN FAILED TO MAP " + filename + "!" };
+
+		m_data = static_cast<const std::byte*>(data);
+		m_size = static_cast<size_t>(status.st_size);
+		m_mapped = true;
+#endif
+	}
+
+	void mapped_file::close()
+	{
+		if (m_mapped)
+		{
+#if defined(_WIN32)
+			UnmapViewOfFile(m_data);
+#elif !defined(ANDROID) && !defined(__ANDROID__)
+			munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+		}
+
+		m_data = nullptr;
+		m_size = 0;
+		m_mapped = false;
+
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+	}
+
+	bool mapped_file::is_open() const
+	{
+		return m_data != nullptr;
+	}
+
+	const std::byte* mapped_file::get_data() const
+	{
+		return m_data;
+	}
+
+	size_t mapped_file::get_size() const
+	{
+		return m_size;
+	}
+}
@@ -0,0 +1,31 @@
+#include "utility/cpu_features.h"
+
+namespace age
+{
+	namespace cpu_features
+	{
+		bool has_avx2()
+		{
+#if defined(AGE_SIMD_X86)
+	#if defined(_MSC_VER) && !defined(__clang__)
+			int registers[4];
+			__cpuid(registers, 0);
+			if (registers[0] < 7)
+				return false;
+
+			//The OS has to save the YMM registers
+			__cpuid(registers, 1);
+			bool os_saves_ymm = (registers[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+
+			__cpuidex(registers, 7, 0);
+			return os_saves_ymm && (registers[1] & (1 << 5));
+	#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+	#endif
+#else
+			return false;
+#endif
+		}
+	}
+}
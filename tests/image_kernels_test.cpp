@@ -0,0 +1,175 @@
+//The kernels are in an anonymous namespace, so the source is included to test every implementation the CPU supports
+#include "../src/graphics/image_kernels.cpp"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using namespace age;
+
+	using pixels = std::vector<uint8_t>;
+
+	std::vector<image_kernels> get_supported_kernels()
+	{
+		std::vector<image_kernels> kernels;
+
+#if defined(AGE_SIMD_X86)
+		kernels.push_back(image_kernels{ fill_sse2, mask_sse2, reverse_sse2, swap_sse2, premultiply_sse2, unpremultiply_sse2, swap_red_blue_sse2, "sse2" });
+		if (cpu_features::has_avx2())
+			kernels.push_back(image_kernels{ fill_avx2, mask_avx2, reverse_avx2, swap_sse2, premultiply_avx2, unpremultiply_sse2, swap_red_blue_avx2, "avx2" });
+#elif defined(AGE_SIMD_NEON)
+		kernels.push_back(image_kernels{ fill_neon, mask_neon, reverse_neon, swap_neon, premultiply_neon, unpremultiply_scalar, swap_red_blue_neon, "neon" });
+#endif
+
+		//The dispatched table has to be one of the tested ones, or scalar
+		kernels.push_back(get_kernels());
+
+		return kernels;
+	}
+
+	pixels make_pixels(std::mt19937& rng, size_t count)
+	{
+		pixels result(count * 4);
+		for (auto& value : result)
+			value = static_cast<uint8_t>(rng());
+
+		//Fully transparent and opaque pixels take special paths when unpremultiplying
+		for (size_t i = 0; i < count; i += 3)
+			result[4 * i + 3] = (rng() & 1) ? 0 : 255;
+
+		return result;
+	}
+
+	//Every combination of a color value and alpha
+	pixels make_all_pixels()
+	{
+		pixels result(256 * 256 * 4);
+
+		for (size_t value = 0; value < 256; ++value)
+		{
+			for (size_t alpha = 0; alpha < 256; ++alpha)
+			{
+				uint8_t* pixel = &result[(value * 256 + alpha) * 4];
+				pixel[0] = static_cast<uint8_t>(value);
+				pixel[1] = static_cast<uint8_t>(255 - value);
+				pixel[2] = static_cast<uint8_t>(value / 2);
+				pixel[3] = static_cast<uint8_t>(alpha);
+			}
+		}
+
+		return result;
+	}
+
+	int failures = 0;
+
+	void check(const image_kernels& kernels, const char* kernel, size_t count, const pixels& result, const pixels& expected)
+	{
+		if (result != expected)
+		{
+			std::printf("FAILED %s %s count %zu\n", kernels.isa, kernel, count);
+			++failures;
+		}
+	}
+
+	void test_kernels(const image_kernels& kernels, const pixels& source)
+	{
+		size_t count = source.size() / 4;
+
+		{
+			pixels result = source, expected = source;
+			kernels.premultiply(result.data(), count);
+			premultiply_scalar(expected.data(), count);
+			check(kernels, "premultiply", count, result, expected);
+		}
+
+		{
+			pixels result = source, expected = source;
+			kernels.unpremultiply(result.data(), count);
+			unpremultiply_scalar(expected.data(), count);
+			check(kernels, "unpremultiply", count, result, expected);
+		}
+
+		{
+			pixels result = source, expected = source;
+			kernels.swap_red_blue(result.data(), count);
+			swap_red_blue_scalar(expected.data(), count);
+			check(kernels, "swap_red_blue", count, result, expected);
+		}
+
+		{
+			pixels result = source, expected = source;
+			kernels.reverse(result.data(), count);
+			reverse_scalar(expected.data(), count);
+			check(kernels, "reverse", count, result, expected);
+		}
+
+		{
+			pixels result = source, expected = source;
+			kernels.fill(result.data(), count, 0x11223344u);
+			fill_scalar(expected.data(), count, 0x11223344u);
+			check(kernels, "fill", count, result, expected);
+		}
+
+		{
+			//The key is taken from the pixels, so some of them match
+			uint32_t key = 0;
+			if (count > 0)
+				std::memcpy(&key, &source[4 * (count / 2)], sizeof(key));
+
+			pixels result = source, expected = source;
+			kernels.mask(result.data(), count, key, 7);
+			mask_scalar(expected.data(), count, key, 7);
+			check(kernels, "mask", count, result, expected);
+		}
+
+		{
+			pixels other(source.rbegin(), source.rend());
+
+			pixels result = source, expected = source;
+			pixels other_result = other, other_expected = other;
+			kernels.swap(result.data(), other_result.data(), count);
+			swap_scalar(expected.data(), other_expected.data(), count);
+			check(kernels, "swap", count, result, expected);
+			check(kernels, "swap", count, other_result, other_expected);
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 rng{ 1 };
+
+	auto kernels = get_supported_kernels();
+	std::printf("image kernels run with %s\n", get_image_kernels_isa());
+
+	//Counts up to several SIMD widths cover the remainder loops
+	for (size_t count = 0; count < 200; ++count)
+	{
+		pixels source = make_pixels(rng, count);
+
+		for (const auto& k : kernels)
+			test_kernels(k, source);
+	}
+
+	pixels all = make_all_pixels();
+	for (const auto& k : kernels)
+		test_kernels(k, all);
+
+	//The scalar reference itself has to round exactly
+	for (uint32_t value = 0; value < 256; ++value)
+	{
+		for (uint32_t alpha = 0; alpha < 256; ++alpha)
+		{
+			if (modulate(static_cast<uint8_t>(value), static_cast<uint8_t>(alpha)) != (value * alpha + 127) / 255)
+			{
+				std::printf("FAILED modulate %u %u\n", value, alpha);
+				++failures;
+			}
+		}
+	}
+
+	std::printf("%d failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+//The kernels are in an anonymous namespace, so the source is included to test every implementation the CPU supports
+#include "../src/graphics/vertex_kernels.cpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	using namespace age;
+
+	using transform_kernel = void (*)(vertex_2d*, size_t, const affine_2d&);
+
+	struct named_kernel
+	{
+		const char* isa;
+		transform_kernel transform;
+	};
+
+	std::vector<named_kernel> get_supported_kernels()
+	{
+		std::vector<named_kernel> kernels{ { "scalar", transform_scalar } };
+
+#if defined(AGE_SIMD_X86)
+		kernels.push_back({ "sse2", transform_sse2 });
+		if (cpu_features::has_avx2())
+			kernels.push_back({ "avx2", transform_avx2 });
+#elif defined(AGE_SIMD_NEON)
+		kernels.push_back({ "neon", transform_neon });
+#endif
+
+		return kernels;
+	}
+
+	std::vector<glm::mat4> get_transforms()
+	{
+		glm::mat4 identity{ 1.0f };
+
+		glm::mat4 combined = glm::translate(identity, glm::vec3{ 123.5f, -42.25f, 0.0f });
+		combined = glm::rotate(combined, 0.7f, glm::vec3{ 0.0f, 0.0f, 1.0f });
+		combined = glm::scale(combined, glm::vec3{ 1.5f, -0.75f, 1.0f });
+
+		return {
+			identity,
+			glm::translate(identity, glm::vec3{ 10.0f, -20.0f, 0.0f }),
+			glm::rotate(identity, 1.25f, glm::vec3{ 0.0f, 0.0f, 1.0f }),
+			glm::scale(identity, glm::vec3{ 2.0f, 0.5f, 1.0f }),
+			combined
+		};
+	}
+
+	bool nearly_equal(float a, float b)
+	{
+		return std::fabs(a - b) <= 1e-4f * std::max(1.0f, std::max(std::fabs(a), std::fabs(b)));
+	}
+}
+
+int main()
+{
+	std::mt19937 rng{ 1 };
+	std::uniform_real_distribution<float> coordinate{ -1000.0f, 1000.0f };
+
+	auto kernels = get_supported_kernels();
+	auto transforms = get_transforms();
+	int failures = 0;
+
+	std::printf("vertex kernels run with %s\n", get_vertex_kernels_isa());
+
+	//Counts around the SIMD widths cover the remainder loops
+	for (size_t count = 0; count <= 19; ++count)
+	{
+		std::vector<vertex_2d> source(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			glm::vec2 position{ coordinate(rng), coordinate(rng) };
+			glm::vec2 tex_coords{ coordinate(rng), coordinate(rng) };
+			color value{ static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()) };
+
+			source[i] = vertex_2d{ position, value, tex_coords };
+		}
+
+		for (size_t t = 0; t < transforms.size(); ++t)
+		{
+			const glm::mat4& transform = transforms[t];
+
+			std::vector<vertex_2d> expected = source;
+			transform_scalar(expected.data(), count, to_affine(transform));
+
+			for (const auto& kernel : kernels)
+			{
+				std::vector<vertex_2d> vertices = source;
+				kernel.transform(vertices.data(), count, to_affine(transform));
+
+				for (size_t i = 0; i < count; ++i)
+				{
+					glm::vec4 reference = transform * glm::vec4{ source[i].position, 0.0f, 1.0f };
+					const vertex_2d& v = vertices[i];
+
+					bool matches_glm = nearly_equal(v.position.x, reference.x) && nearly_equal(v.position.y, reference.y);
+					//The SIMD code has to produce exactly the results of the scalar code
+					bool matches_scalar = v.position == expected[i].position;
+					bool untouched = v.color == source[i].color && v.tex_coords == source[i].tex_coords;
+
+					if (!matches_glm || !matches_scalar || !untouched)
+					{
+						std::printf("FAILED %s transform %zu count %zu vertex %zu: (%g, %g), glm (%g, %g), scalar (%g, %g)\n",
+							kernel.isa, t, count, i,
+							v.position.x, v.position.y,
+							reference.x, reference.y,
+							expected[i].position.x, expected[i].position.y);
+
+						++failures;
+					}
+				}
+			}
+		}
+	}
+
+	//The public entry point goes through the runtime dispatch
+	std::vector<vertex_2d> vertices(7, vertex_2d{ glm::vec2{ 3.0f, 4.0f } });
+	transform_positions(vertices.data(), vertices.size(), transforms.back());
+
+	glm::vec4 reference = transforms.back() * glm::vec4{ 3.0f, 4.0f, 0.0f, 1.0f };
+	for (const auto& v : vertices)
+	{
+		if (!nearly_equal(v.position.x, reference.x) || !nearly_equal(v.position.y, reference.y))
+		{
+			std::printf("FAILED transform_positions: (%g, %g), glm (%g, %g)\n", v.position.x, v.position.y, reference.x, reference.y);
+			++failures;
+		}
+	}
+
+	set_colors(vertices.data(), vertices.size(), color{ 1, 2, 3, 4 });
+	for (const auto& v : vertices)
+	{
+		if (!(v.color == color{ 1, 2, 3, 4 }))
+		{
+			std::printf("FAILED set_colors\n");
+			++failures;
+		}
+	}
+
+	std::printf("%d failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}